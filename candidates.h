@@ -0,0 +1,98 @@
+#pragma once
+#include "point.h"
+#include "kd_tree.h"
+#include "grid_index.h"
+#include <vector>
+#include <cstdint>
+#include <algorithm>
+
+// Listas de candidatos: los K vecinos más cercanos de cada ciudad en un único
+// arreglo plano neighbors[c * k .. c * k + counts[c]), ordenados de más
+// cercano a más lejano. Se calculan una sola vez por instancia.
+struct CandidateLists {
+    // Rango de candidatos de una ciudad (para usar en range-for)
+    struct Range {
+        const uint32_t* first;
+        const uint32_t* last;
+        const uint32_t* begin() const { return first; }
+        const uint32_t* end() const { return last; }
+        size_t size() const { return last - first; }
+    };
+    
+    size_t k;                          // Capacidad por ciudad
+    std::vector<uint32_t> neighbors;   // n * k índices de ciudades
+    std::vector<uint32_t> counts;      // Candidatos válidos por ciudad (<= k)
+    size_t nodes_visited;              // Nodos/celdas del índice visitados al construir
+    
+    CandidateLists() : k(0), nodes_visited(0) {}
+    
+    size_t size() const { return counts.size(); }
+    
+    Range of(uint32_t city) const {
+        const uint32_t* first = neighbors.data() + static_cast<size_t>(city) * k;
+        return {first, first + counts[city]};
+    }
+    
+    // Construye las listas con un índice espacial ya construido sobre `points`
+    void build(const PointSet& points, const KDTree& tree, size_t num_neighbors) {
+        build_with(points, tree, num_neighbors);
+    }
+    
+    void build(const PointSet& points, const GridIndex& grid, size_t num_neighbors) {
+        build_with(points, grid, num_neighbors);
+    }
+    
+    // Construye las listas creando un K-d tree temporal con buckets de leaf_size
+    void build(const PointSet& points, size_t num_neighbors,
+               size_t leaf_size = KDTree::default_leaf_size) {
+        KDTree tree(leaf_size);
+        tree.build(points);
+        build(points, tree, num_neighbors);
+    }
+    
+    // Listas balanceadas por cuadrante: los k_per_quadrant vecinos más
+    // cercanos en cada cuadrante alrededor de la ciudad (hasta 4 * k_per_quadrant
+    // por ciudad, de más cercano a más lejano). Cubren las direcciones que una
+    // lista K-NN pierde en los bordes de los clusters.
+    void build_quadrant(const PointSet& points, const KDTree& tree, size_t k_per_quadrant) {
+        size_t n = points.size();
+        k = std::min(4 * k_per_quadrant, n > 0 ? n - 1 : 0);
+        neighbors.assign(n * k, 0);
+        counts.assign(n, 0);
+        nodes_visited = 0;
+        
+        for (size_t c = 0; c < n; ++c) {
+            auto nearest = tree.find_quadrant_neighbors(points[c], k_per_quadrant, static_cast<uint32_t>(c));
+            nodes_visited += tree.get_nodes_visited();
+            
+            uint32_t count = static_cast<uint32_t>(std::min(nearest.size(), k));
+            std::copy(nearest.begin(), nearest.begin() + count, neighbors.begin() + c * k);
+            counts[c] = count;
+        }
+    }
+
+private:
+    // Index: KDTree o GridIndex (misma interfaz de consultas)
+    template <class Index>
+    void build_with(const PointSet& points, const Index& index, size_t num_neighbors) {
+        size_t n = points.size();
+        k = std::min(num_neighbors, n > 0 ? n - 1 : 0);
+        neighbors.assign(n * k, 0);
+        counts.assign(n, 0);
+        nodes_visited = 0;
+        
+        for (size_t c = 0; c < n; ++c) {
+            // k + 1 porque la consulta incluye a la propia ciudad
+            auto nearest = index.find_k_nearest_neighbors(points[c], k + 1);
+            nodes_visited += index.get_nodes_visited();
+            
+            uint32_t* out = neighbors.data() + c * k;
+            uint32_t count = 0;
+            for (uint32_t neighbor : nearest) {
+                if (neighbor == c || count == k) continue;
+                out[count++] = neighbor;
+            }
+            counts[c] = count;
+        }
+    }
+};
@@ -0,0 +1,570 @@
+#pragma once
+#include "point.h"
+#include "tour.h"
+#include "kd_tree.h"
+#include "thread_pool.h"
+#include "candidates.h"
+#include <vector>
+#include <limits>
+#include <chrono>
+#include <algorithm>
+#include <cstring>
+#include <cstdint>
+#include <queue>
+
+// =============== CONSTRUCCIÓN DE TOURS CON ÍNDICE ESPACIAL ===============
+// Variantes de las heurísticas de construcción de point.h que usan un índice
+// espacial (KDTree o GridIndex) en lugar de recorrer todos los puntos.
+// Index debe ofrecer build(points) y find_nearest_neighbor(query, excluded).
+
+// Heurística Nearest Neighbor: cada paso consulta el vecino más cercano no
+// visitado en el índice (los visitados se pasan como conjunto excluido)
+template <class Index>
+inline Tour spatial_nearest_neighbor_tour(const PointSet& points, const Index& index, size_t start_idx = 0) {
+    if (points.empty()) return {};
+    
+    std::vector<uint32_t> order;
+    std::vector<bool> visited(points.size(), false);
+    order.reserve(points.size());
+    
+    uint32_t current = static_cast<uint32_t>(start_idx);
+    order.push_back(current);
+    visited[current] = true;
+    
+    for (size_t step = 1; step < points.size(); ++step) {
+        uint32_t next = index.find_nearest_neighbor(points[current], visited);
+        order.push_back(next);
+        visited[next] = true;
+        current = next;
+    }
+    
+    return Tour(std::move(order));
+}
+
+// Orden NN desde start_idx sobre un K-d tree, escrito en `order`; `unvisited`
+// se reinicia y sirve de buffer reutilizable entre llamadas. Los visitados se
+// borran del AliveSet, de modo que los subárboles agotados se podan y cada
+// paso cuesta ~O(log n) en la práctica en vez de degenerar a O(n) al final del
+// tour. Devuelve la longitud del tour cerrado.
+inline double nearest_neighbor_order(const PointSet& points, const KDTree& tree, size_t start_idx,
+                                     KDTree::AliveSet& unvisited, std::vector<uint32_t>& order) {
+    order.clear();
+    if (points.empty()) return 0.0;
+    
+    tree.reset_alive_set(unvisited);
+    uint32_t current = static_cast<uint32_t>(start_idx);
+    order.push_back(current);
+    tree.remove(unvisited, current);
+    
+    double length = 0.0;
+    while (!unvisited.empty()) {
+        uint32_t next = tree.find_nearest_neighbor(points[current], unvisited);
+        order.push_back(next);
+        tree.remove(unvisited, next);
+        length += distance(points, current, next);
+        current = next;
+    }
+    return length + distance(points, current, order.front());
+}
+
+// Con K-d tree: O(n log n) en total. Produce el mismo tour que
+// nearest_neighbor_tour de point.h para el mismo inicio.
+inline Tour spatial_nearest_neighbor_tour(const PointSet& points, const KDTree& tree, size_t start_idx = 0) {
+    KDTree::AliveSet unvisited;
+    std::vector<uint32_t> order;
+    nearest_neighbor_order(points, tree, start_idx, unvisited, order);
+    return Tour(std::move(order));
+}
+
+// Mejor tour NN entre varios puntos de inicio, reutilizando el mismo índice
+template <class Index>
+inline Tour best_spatial_nearest_neighbor_tour(const PointSet& points, const Index& index, size_t num_starts = 10) {
+    if (points.empty()) return {};
+    
+    Tour best_tour;
+    double best_length = std::numeric_limits<double>::max();
+    
+    for (size_t start = 0; start < std::min(num_starts, points.size()); ++start) {
+        Tour tour = spatial_nearest_neighbor_tour(points, index, start);
+        double length = tour_length(points, tour);
+        
+        if (length < best_length) {
+            best_length = length;
+            best_tour = std::move(tour);
+        }
+    }
+    
+    return best_tour;
+}
+
+// Opciones del multi-inicio NN paralelo
+struct MultiStartOptions {
+    size_t num_starts;     // Inicios a probar: 0, 1, ..., num_starts - 1
+    size_t num_threads;    // Hilos (0 = núcleos disponibles)
+    double time_budget;    // Presupuesto de reloj en segundos (0 = sin límite)
+    
+    MultiStartOptions() : num_starts(10), num_threads(1), time_budget(0.0) {}
+};
+
+struct MultiStartStats {
+    size_t starts_done = 0;
+    size_t best_start = 0;
+    double best_length = 0.0;
+    double wall_time = 0.0;
+};
+
+// Mejor tour NN entre varios inicios repartidos en un pool de hilos. Cada
+// worker construye sobre su propio AliveSet y buffers de índices (el árbol es
+// compartido y de solo lectura) y solo guarda su mejor permutación; al final
+// se materializa un único Tour. Con time_budget > 0 no se empiezan inicios
+// nuevos pasado el plazo (el inicio 0 siempre se construye). Sin presupuesto
+// el resultado es el mismo que best_spatial_nearest_neighbor_tour: ante
+// longitudes iguales gana el menor inicio, sin importar los hilos.
+inline Tour parallel_best_nearest_neighbor_tour(const PointSet& points, const KDTree& tree,
+                                                const MultiStartOptions& options = MultiStartOptions(),
+                                                MultiStartStats* stats = nullptr) {
+    if (points.empty()) return {};
+    
+    auto start_time = std::chrono::steady_clock::now();
+    auto deadline = start_time + std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+                                     std::chrono::duration<double>(options.time_budget));
+    size_t num_starts = std::max<size_t>(1, std::min(options.num_starts, points.size()));
+    
+    struct WorkerState {
+        KDTree::AliveSet unvisited;
+        std::vector<uint32_t> order, best_order;
+        double best_length = std::numeric_limits<double>::max();
+        size_t best_start = 0;
+        size_t starts_done = 0;
+    };
+    ThreadPool pool(options.num_threads);
+    std::vector<WorkerState> workers(pool.size());
+    
+    pool.parallel_for(num_starts, [&](size_t start, size_t worker) {
+        if (start > 0 && options.time_budget > 0 && std::chrono::steady_clock::now() >= deadline) return;
+        
+        WorkerState& state = workers[worker];
+        double length = nearest_neighbor_order(points, tree, start, state.unvisited, state.order);
+        state.starts_done++;
+        if (length < state.best_length || (length == state.best_length && start < state.best_start)) {
+            state.best_length = length;
+            state.best_start = start;
+            state.best_order.swap(state.order);
+        }
+    });
+    
+    WorkerState* best = nullptr;
+    size_t starts_done = 0;
+    for (WorkerState& state : workers) {
+        starts_done += state.starts_done;
+        if (state.starts_done == 0) continue;
+        if (!best || state.best_length < best->best_length ||
+            (state.best_length == best->best_length && state.best_start < best->best_start)) {
+            best = &state;
+        }
+    }
+    
+    if (stats) {
+        stats->starts_done = starts_done;
+        stats->best_start = best->best_start;
+        stats->best_length = best->best_length;
+        stats->wall_time = std::chrono::duration<double>(std::chrono::steady_clock::now() - start_time).count();
+    }
+    return Tour(std::move(best->best_order));
+}
+
+// Ordenamiento radix LSD estable por claves enteras sin signo (uint32_t o
+// uint64_t), un byte por pasada; los bytes iguales en todas las claves se
+// saltan. Devuelve la permutación que ordena `keys` de menor a mayor.
+template <class Key>
+inline std::vector<uint32_t> radix_sort_order(const std::vector<Key>& keys) {
+    size_t m = keys.size();
+    std::vector<uint32_t> order(m), buffer(m);
+    for (size_t i = 0; i < m; ++i) order[i] = static_cast<uint32_t>(i);
+    
+    for (size_t shift = 0; shift < 8 * sizeof(Key); shift += 8) {
+        size_t count[257] = {0};
+        for (size_t i = 0; i < m; ++i) count[((keys[i] >> shift) & 0xFF) + 1]++;
+        if (std::find(count + 1, count + 257, m) != count + 257) continue;
+        
+        for (size_t b = 0; b < 256; ++b) count[b + 1] += count[b];
+        for (uint32_t idx : order) buffer[count[(keys[idx] >> shift) & 0xFF]++] = idx;
+        order.swap(buffer);
+    }
+    return order;
+}
+
+// Caminos disjuntos para las construcciones por aristas (Greedy Edge, savings):
+// hasta dos vecinos por ciudad y union-find (compresión por mitades) para no
+// cerrar ciclos. close() completa el tour: encadena los fragmentos uniendo el
+// extremo libre con el extremo más cercano de otro fragmento (K-d tree con un
+// AliveSet que solo contiene extremos) y recorre el ciclo desde la ciudad 0.
+struct PathFragments {
+    static constexpr uint32_t none = std::numeric_limits<uint32_t>::max();
+    std::vector<uint32_t> adj;      // adj[2c], adj[2c + 1]: vecinos de c (none si no hay)
+    std::vector<uint32_t> parent;
+    std::vector<uint8_t> degree;
+    
+    explicit PathFragments(size_t n) : adj(2 * n, none), parent(n), degree(n, 0) {
+        for (size_t i = 0; i < n; ++i) parent[i] = static_cast<uint32_t>(i);
+    }
+    
+    uint32_t find(uint32_t c) {
+        while (parent[c] != c) {
+            parent[c] = parent[parent[c]];
+            c = parent[c];
+        }
+        return c;
+    }
+    
+    void link(uint32_t a, uint32_t b) {
+        adj[2 * a + degree[a]++] = b;
+        adj[2 * b + degree[b]++] = a;
+    }
+    
+    // Une a y b si ambos son extremos de fragmentos distintos
+    bool try_join(uint32_t a, uint32_t b) {
+        if (degree[a] == 2 || degree[b] == 2) return false;
+        uint32_t root_a = find(a), root_b = find(b);
+        if (root_a == root_b) return false;
+        link(a, b);
+        parent[root_a] = root_b;
+        return true;
+    }
+    
+    Tour close(const PointSet& points, const KDTree& tree) {
+        size_t n = degree.size();
+        
+        // Otro extremo de cada fragmento (una ciudad aislada es su propio extremo)
+        std::vector<uint32_t> other_end(n, none);
+        for (uint32_t c = 0; c < n; ++c) {
+            if (degree[c] == 2 || other_end[c] != none) continue;
+            uint32_t prev = none, cur = c;
+            while (true) {
+                uint32_t next = adj[2 * cur] != prev ? adj[2 * cur] : adj[2 * cur + 1];
+                if (next == none) break;
+                prev = cur;
+                cur = next;
+            }
+            other_end[c] = cur;
+            other_end[cur] = c;
+        }
+        
+        // Encadenar fragmentos por el extremo libre más cercano
+        KDTree::AliveSet free_ends = tree.make_alive_set();
+        uint32_t head = none;
+        for (uint32_t c = 0; c < n; ++c) {
+            if (degree[c] == 2) tree.remove(free_ends, c);
+            else if (head == none) head = c;
+        }
+        uint32_t tail = other_end[head];
+        tree.remove(free_ends, head);
+        tree.remove(free_ends, tail);
+        while (!free_ends.empty()) {
+            uint32_t next = tree.find_nearest_neighbor(points[tail], free_ends);
+            tree.remove(free_ends, next);
+            tree.remove(free_ends, other_end[next]);
+            link(tail, next);
+            tail = other_end[next];
+        }
+        link(tail, head);
+        
+        // Recorrer el ciclo desde la ciudad 0
+        std::vector<uint32_t> order;
+        order.reserve(n);
+        uint32_t prev = adj[1], cur = 0;
+        for (size_t step = 0; step < n; ++step) {
+            order.push_back(cur);
+            uint32_t next = adj[2 * cur] != prev ? adj[2 * cur] : adj[2 * cur + 1];
+            prev = cur;
+            cur = next;
+        }
+        return Tour(std::move(order));
+    }
+};
+
+// =============== GREEDY EDGE (MATCHING GREEDY) ===============
+// Aristas candidatas de las listas K-NN ordenadas por longitud (radix sort
+// sobre la longitud en float: para valores no negativos sus bits ordenan
+// igual que el número). Se acepta una arista si sus extremos tienen grado < 2
+// y están en fragmentos distintos; los fragmentos que quedan se encadenan por
+// el extremo más cercano (PathFragments::close). O(n k log n).
+inline Tour greedy_edge_tour(const PointSet& points, const KDTree& tree, const CandidateLists& candidates) {
+    size_t n = points.size();
+    if (n < 3) return Tour::identity(n);
+    
+    // Aristas candidatas sin duplicar (a, b) y (b, a)
+    std::vector<uint32_t> edge_a, edge_b, keys;
+    for (uint32_t a = 0; a < n; ++a) {
+        for (uint32_t b : candidates.of(a)) {
+            auto back = candidates.of(b);
+            if (b < a && std::find(back.begin(), back.end(), a) != back.end()) continue;
+            float length = static_cast<float>(distance(points, a, b));
+            uint32_t key;
+            std::memcpy(&key, &length, sizeof(key));
+            edge_a.push_back(a);
+            edge_b.push_back(b);
+            keys.push_back(key);
+        }
+    }
+    
+    PathFragments fragments(n);
+    for (uint32_t e : radix_sort_order(keys)) fragments.try_join(edge_a[e], edge_b[e]);
+    return fragments.close(points, tree);
+}
+
+// =============== AHORROS (CLARKE-WRIGHT) ===============
+// Depósito h: la ciudad más cercana al centroide. El ahorro de unir i y j es
+// s(i, j) = d(h, i) + d(h, j) - d(i, j), pero solo se evalúan los pares de las
+// listas K-NN (sin matriz O(n^2)). Los pares se procesan de mayor a menor
+// ahorro con un heap y se unen si ambos son extremos de caminos distintos
+// (union-find); el depósito y los caminos que quedan se encadenan al final
+// por el extremo más cercano, como en Greedy Edge. O(n k log n).
+inline Tour savings_tour(const PointSet& points, const KDTree& tree, const CandidateLists& candidates) {
+    size_t n = points.size();
+    if (n < 3) return Tour::identity(n);
+    
+    double cx = 0, cy = 0;
+    for (size_t i = 0; i < n; ++i) {
+        cx += points.xs[i];
+        cy += points.ys[i];
+    }
+    uint32_t hub = tree.find_nearest_neighbor(Point(cx / n, cy / n));
+    
+    struct Saving {
+        double value;
+        uint32_t a, b;
+        bool operator<(const Saving& other) const { return value < other.value; }
+    };
+    std::vector<Saving> savings;
+    savings.reserve(n * candidates.k);
+    for (uint32_t a = 0; a < n; ++a) {
+        if (a == hub) continue;
+        double d_ha = distance(points, hub, a);
+        for (uint32_t b : candidates.of(a)) {
+            if (b == hub) continue;
+            auto back = candidates.of(b);
+            if (b < a && std::find(back.begin(), back.end(), a) != back.end()) continue;
+            savings.push_back({d_ha + distance(points, hub, b) - distance(points, a, b), a, b});
+        }
+    }
+    
+    // Heap de máximos construido en O(m); cada extracción O(log m)
+    std::priority_queue<Saving> heap(std::less<Saving>(), std::move(savings));
+    PathFragments fragments(n);
+    while (!heap.empty()) {
+        Saving s = heap.top();
+        heap.pop();
+        fragments.try_join(s.a, s.b);
+    }
+    return fragments.close(points, tree);
+}
+
+// =============== INSERCIÓN (MÁS LEJANA / MÁS BARATA) ===============
+// Tour parcial como lista doblemente enlazada por ciudad. Las ciudades ya
+// insertadas forman un AliveSet del K-d tree que crece con revive, y la mejor
+// posición para c se busca solo en las aristas incidentes a sus
+// `neighbors` vecinos insertados más cercanos (ambos lados de cada uno), en
+// lugar de en las n aristas del tour.
+struct PartialTour {
+    const PointSet& points;
+    const KDTree& tree;
+    size_t neighbors;
+    std::vector<uint32_t> next, prev;
+    KDTree::AliveSet inserted;
+    
+    PartialTour(const PointSet& points, const KDTree& tree, size_t neighbors, uint32_t start)
+        : points(points), tree(tree), neighbors(neighbors),
+          next(points.size(), start), prev(points.size(), start), inserted(tree.make_alive_set(false)) {
+        tree.revive(inserted, start);
+    }
+    
+    // Mejor inserción de c: {costo, a} para insertar entre a y next[a]
+    std::pair<double, uint32_t> best_insertion(uint32_t c) const {
+        std::pair<double, uint32_t> best(std::numeric_limits<double>::max(), 0);
+        auto consider = [&](uint32_t a) {
+            uint32_t b = next[a];
+            double cost = distance(points, a, c) + distance(points, c, b) - distance(points, a, b);
+            if (cost < best.first) best = {cost, a};
+        };
+        for (uint32_t u : tree.find_k_nearest_neighbors(points[c], neighbors, inserted)) {
+            consider(u);
+            consider(prev[u]);
+        }
+        return best;
+    }
+    
+    void insert(uint32_t c, uint32_t a) {
+        uint32_t b = next[a];
+        next[a] = c;
+        prev[c] = a;
+        next[c] = b;
+        prev[b] = c;
+        tree.revive(inserted, c);
+    }
+    
+    Tour to_tour(uint32_t start) const {
+        std::vector<uint32_t> order;
+        order.reserve(points.size());
+        uint32_t c = start;
+        do {
+            order.push_back(c);
+            c = next[c];
+        } while (c != start);
+        return Tour(std::move(order));
+    }
+};
+
+// Inserción más lejana: en cada paso entra la ciudad más alejada del tour
+// parcial, en su posición más barata. Las distancias al tour solo decrecen,
+// así que se guardan en un heap de máximos con invalidación perezosa: al
+// extraer una ciudad se recalcula su distancia (NN sobre las insertadas) y,
+// si bajó, se reinserta con el valor nuevo; si no, es el máximo real.
+inline Tour farthest_insertion_tour(const PointSet& points, const KDTree& tree,
+                                    size_t start_idx = 0, size_t neighbors = 8) {
+    size_t n = points.size();
+    if (n < 3) return Tour::identity(n);
+    
+    uint32_t start = static_cast<uint32_t>(start_idx);
+    PartialTour partial(points, tree, neighbors, start);
+    
+    std::vector<std::pair<double, uint32_t>> entries;
+    entries.reserve(n - 1);
+    for (uint32_t c = 0; c < n; ++c) {
+        if (c != start) entries.push_back({distance(points, start, c), c});
+    }
+    std::priority_queue<std::pair<double, uint32_t>> heap(std::less<std::pair<double, uint32_t>>(),
+                                                          std::move(entries));
+    
+    while (!heap.empty()) {
+        auto [key, c] = heap.top();
+        heap.pop();
+        
+        uint32_t nearest = tree.find_nearest_neighbor(points[c], partial.inserted);
+        double dist = distance(points, c, nearest);
+        if (dist < key) {
+            heap.push({dist, c});
+            continue;
+        }
+        partial.insert(c, partial.best_insertion(c).second);
+    }
+    return partial.to_tour(start);
+}
+
+// Inserción más barata: en cada paso entra la ciudad con menor costo de
+// inserción. Heap de mínimos con invalidación perezosa: key[c] es el último
+// costo publicado (las entradas que no coinciden se descartan). Tras insertar
+// c se recalculan sus vecinos candidatos, que pueden abaratarse con las
+// aristas nuevas; los que se encarecieron porque su arista desapareció se
+// detectan al extraerlos y se reinsertan con el costo actual.
+inline Tour cheapest_insertion_tour(const PointSet& points, const KDTree& tree, const CandidateLists& candidates,
+                                    size_t start_idx = 0, size_t neighbors = 8) {
+    size_t n = points.size();
+    if (n < 3) return Tour::identity(n);
+    
+    uint32_t start = static_cast<uint32_t>(start_idx);
+    PartialTour partial(points, tree, neighbors, start);
+    std::vector<uint8_t> done(n, 0);
+    done[start] = 1;
+    
+    using Entry = std::pair<double, uint32_t>;
+    std::vector<double> key(n, std::numeric_limits<double>::max());
+    std::vector<Entry> entries;
+    entries.reserve(n - 1);
+    for (uint32_t c = 0; c < n; ++c) {
+        if (c == start) continue;
+        key[c] = partial.best_insertion(c).first;
+        entries.push_back({key[c], c});
+    }
+    std::priority_queue<Entry, std::vector<Entry>, std::greater<Entry>> heap(std::greater<Entry>(),
+                                                                             std::move(entries));
+    
+    while (!heap.empty()) {
+        auto [cost, c] = heap.top();
+        heap.pop();
+        if (done[c] || cost != key[c]) continue;
+        
+        auto [current, after] = partial.best_insertion(c);
+        if (current > cost) {
+            key[c] = current;
+            heap.push({current, c});
+            continue;
+        }
+        partial.insert(c, after);
+        done[c] = 1;
+        
+        for (uint32_t x : candidates.of(c)) {
+            if (done[x]) continue;
+            double updated = partial.best_insertion(x).first;
+            if (updated < key[x]) {
+                key[x] = updated;
+                heap.push({updated, x});
+            }
+        }
+    }
+    return partial.to_tour(start);
+}
+
+// =============== CURVA DE HILBERT ===============
+// Índice de Hilbert de la celda (x, y) en una grilla de 2^32 x 2^32 (clave de
+// 64 bits). Versión iterativa clásica: por cada nivel suma el cuadrante y rota
+// el resto de los bits (~x equivale a n - 1 - x con n = 2^32).
+inline uint64_t hilbert_index(uint32_t x, uint32_t y) {
+    uint64_t d = 0;
+    for (uint32_t s = 1u << 31; s > 0; s >>= 1) {
+        uint32_t rx = (x & s) ? 1 : 0;
+        uint32_t ry = (y & s) ? 1 : 0;
+        d += static_cast<uint64_t>(s) * s * ((3 * rx) ^ ry);
+        if (ry == 0) {
+            if (rx == 1) {
+                x = ~x;
+                y = ~y;
+            }
+            std::swap(x, y);
+        }
+    }
+    return d;
+}
+
+// Puntos ordenados a lo largo de la curva de Hilbert: coordenadas cuantizadas
+// a 32 bits sobre el cuadrado envolvente (misma escala en ambos ejes) y radix
+// sort de las claves de 64 bits. O(n) con constante pequeña.
+inline std::vector<uint32_t> hilbert_order(const PointSet& points) {
+    size_t n = points.size();
+    if (n == 0) return {};
+    
+    auto [min_x, max_x] = std::minmax_element(points.xs.begin(), points.xs.end());
+    auto [min_y, max_y] = std::minmax_element(points.ys.begin(), points.ys.end());
+    double extent = std::max(*max_x - *min_x, *max_y - *min_y);
+    double scale = extent > 0 ? 4294967295.0 / extent : 0.0;
+    
+    std::vector<uint64_t> keys(n);
+    for (size_t i = 0; i < n; ++i) {
+        double qx = std::min((points.xs[i] - *min_x) * scale, 4294967295.0);
+        double qy = std::min((points.ys[i] - *min_y) * scale, 4294967295.0);
+        keys[i] = hilbert_index(static_cast<uint32_t>(qx), static_cast<uint32_t>(qy));
+    }
+    return radix_sort_order(keys);
+}
+
+// Tour en el orden de la curva de Hilbert (~12% más largo que NN en
+// instancias uniformes, pero casi instantáneo incluso con millones de puntos)
+inline Tour hilbert_curve_tour(const PointSet& points) {
+    return Tour(hilbert_order(points));
+}
+
+// Renumera los puntos en orden de Hilbert: ciudades cercanas en el plano
+// quedan cercanas en memoria, así los accesos a coordenadas, candidatos y
+// posiciones en los bucles de búsqueda local son locales en caché. Debe
+// llamarse antes de construir índices y candidatos. Devuelve el índice
+// original de cada punto nuevo (para reportar los identificadores de entrada).
+inline std::vector<uint32_t> hilbert_renumber(PointSet& points) {
+    std::vector<uint32_t> order = hilbert_order(points);
+    PointSet renumbered(points.size());
+    for (size_t i = 0; i < order.size(); ++i) {
+        renumbered.xs[i] = points.xs[order[i]];
+        renumbered.ys[i] = points.ys[order[i]];
+    }
+    points = std::move(renumbered);
+    return order;
+}
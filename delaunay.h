@@ -0,0 +1,269 @@
+#pragma once
+#include "point.h"
+#include "candidates.h"
+#include "construction.h"
+#include <vector>
+#include <cstdint>
+#include <algorithm>
+#include <cmath>
+
+// =============== TRIANGULACIÓN DE DELAUNAY ===============
+// Bowyer-Watson incremental con los puntos insertados en orden de Hilbert:
+// cada punto se localiza caminando desde el último triángulo creado (que
+// queda cerca gracias al orden), se quitan los triángulos cuyo circuncírculo
+// lo contiene estrictamente (la cavidad) y se une el punto con el borde de la
+// cavidad. O(n log n) en la práctica.
+// Predicados exactos: las coordenadas se cuantizan a una grilla de 2^22 y los
+// vértices del súper-triángulo quedan en ±2^28/2^29, así que orient cabe en
+// int64 e incircle en __int128 sin redondeo. Los puntos que caen en la misma
+// celda se tratan como duplicados: se encadenan entre sí y heredan los
+// vecinos del punto insertado.
+// El grafo resultante (~6 aristas por ciudad en promedio) sirve como listas
+// de candidatos de tamaño fijo y pequeño, sin radios ni K que ajustar.
+class DelaunayTriangulation {
+private:
+    static constexpr int64_t grid_size = int64_t(1) << 22;
+    static constexpr int64_t super_low = -(int64_t(1) << 28);
+    static constexpr int64_t super_high = (int64_t(1) << 29) - 1;
+    static constexpr uint32_t none = std::numeric_limits<uint32_t>::max();
+    
+    // Triángulo en sentido antihorario; nb[i] es el vecino opuesto a v[i]
+    // (comparte la arista v[i + 1] -> v[i + 2])
+    struct Triangle {
+        uint32_t v[3];
+        uint32_t nb[3];
+        bool alive;
+    };
+    
+    std::vector<int64_t> qx_, qy_;         // Coordenadas cuantizadas (+3 del súper-triángulo)
+    std::vector<Triangle> triangles_;
+    std::vector<uint32_t> free_;           // Triángulos reutilizables
+    std::vector<uint32_t> twin_;           // Punto equivalente ya insertado (none si no es duplicado)
+    std::vector<uint32_t> last_copy_;      // Último duplicado visto de cada punto insertado
+    std::vector<std::pair<uint32_t, uint32_t>> copy_edges_;   // Cadena de duplicados
+    std::vector<uint32_t> edge_start_, edge_to_;   // Grafo en CSR
+    size_t n_;
+    uint32_t last_;                        // Punto de partida de la próxima localización
+    uint64_t walk_state_;
+    
+    // > 0 si c está a la izquierda de a -> b
+    int64_t orient(uint32_t a, uint32_t b, uint32_t c) const {
+        return (qx_[b] - qx_[a]) * (qy_[c] - qy_[a]) - (qy_[b] - qy_[a]) * (qx_[c] - qx_[a]);
+    }
+    
+    // > 0 si d está estrictamente dentro del circuncírculo de (a, b, c) antihorario
+    bool in_circle(const Triangle& t, uint32_t d) const {
+        int64_t adx = qx_[t.v[0]] - qx_[d], ady = qy_[t.v[0]] - qy_[d];
+        int64_t bdx = qx_[t.v[1]] - qx_[d], bdy = qy_[t.v[1]] - qy_[d];
+        int64_t cdx = qx_[t.v[2]] - qx_[d], cdy = qy_[t.v[2]] - qy_[d];
+        __int128 alift = adx * adx + ady * ady;
+        __int128 blift = bdx * bdx + bdy * bdy;
+        __int128 clift = cdx * cdx + cdy * cdy;
+        __int128 det = alift * (bdx * cdy - cdx * bdy)
+                     + blift * (cdx * ady - adx * cdy)
+                     + clift * (adx * bdy - bdx * ady);
+        return det > 0;
+    }
+    
+    uint32_t new_triangle(uint32_t a, uint32_t b, uint32_t c) {
+        Triangle t = {{a, b, c}, {none, none, none}, true};
+        if (!free_.empty()) {
+            uint32_t id = free_.back();
+            free_.pop_back();
+            triangles_[id] = t;
+            return id;
+        }
+        triangles_.push_back(t);
+        return static_cast<uint32_t>(triangles_.size() - 1);
+    }
+    
+    // Camino estocástico: cruza una arista que deja a p del otro lado,
+    // empezando por una arista elegida al azar para no ciclar
+    uint32_t locate(uint32_t p) {
+        uint32_t t = last_;
+        while (true) {
+            walk_state_ ^= walk_state_ << 13;
+            walk_state_ ^= walk_state_ >> 7;
+            walk_state_ ^= walk_state_ << 17;
+            int first = static_cast<int>(walk_state_ % 3);
+            
+            bool moved = false;
+            for (int k = 0; k < 3; ++k) {
+                int i = (first + k) % 3;
+                const Triangle& tri = triangles_[t];
+                if (orient(tri.v[(i + 1) % 3], tri.v[(i + 2) % 3], p) < 0) {
+                    t = tri.nb[i];
+                    moved = true;
+                    break;
+                }
+            }
+            if (!moved) return t;
+        }
+    }
+    
+    void insert(uint32_t p) {
+        uint32_t start = locate(p);
+        for (uint32_t v : triangles_[start].v) {
+            if (qx_[v] == qx_[p] && qy_[v] == qy_[p]) {
+                // Los duplicados forman un camino en vez de una estrella
+                twin_[p] = v;
+                copy_edges_.push_back({last_copy_[v], p});
+                last_copy_[v] = p;
+                return;
+            }
+        }
+        
+        // Cavidad: triángulos conexos cuyo circuncírculo contiene a p
+        std::vector<uint32_t>& cavity = cavity_;
+        cavity.clear();
+        cavity.push_back(start);
+        triangles_[start].alive = false;
+        boundary_.clear();
+        for (size_t k = 0; k < cavity.size(); ++k) {
+            uint32_t t = cavity[k];
+            for (int i = 0; i < 3; ++i) {
+                uint32_t nb = triangles_[t].nb[i];
+                if (nb != none && !triangles_[nb].alive) continue;   // Ya en la cavidad
+                if (nb != none && in_circle(triangles_[nb], p)) {
+                    triangles_[nb].alive = false;
+                    cavity.push_back(nb);
+                } else {
+                    boundary_.push_back({triangles_[t].v[(i + 1) % 3], triangles_[t].v[(i + 2) % 3], nb, t});
+                }
+            }
+        }
+        
+        // Un triángulo (a, b, p) por arista del borde; se enlazan entre sí por
+        // sus vértices compartidos
+        created_.clear();
+        for (const BoundaryEdge& e : boundary_) {
+            uint32_t id = new_triangle(e.a, e.b, p);
+            triangles_[id].nb[2] = e.outside;
+            if (e.outside != none) {
+                Triangle& out = triangles_[e.outside];
+                for (int i = 0; i < 3; ++i) {
+                    if (out.nb[i] == e.inner) out.nb[i] = id;
+                }
+            }
+            created_.push_back(id);
+        }
+        for (uint32_t id : created_) {
+            Triangle& t = triangles_[id];
+            for (uint32_t other : created_) {
+                const Triangle& o = triangles_[other];
+                if (o.v[0] == t.v[1]) t.nb[0] = other;   // Arista b -> p
+                if (o.v[1] == t.v[0]) t.nb[1] = other;   // Arista p -> a
+            }
+        }
+        for (uint32_t t : cavity) free_.push_back(t);
+        last_ = created_.front();
+    }
+    
+    struct BoundaryEdge {
+        uint32_t a, b;        // Arista a -> b del borde (antihoraria vista desde p)
+        uint32_t outside;     // Triángulo vecino fuera de la cavidad
+        uint32_t inner;       // Triángulo de la cavidad que la contenía
+    };
+    std::vector<uint32_t> cavity_, created_;
+    std::vector<BoundaryEdge> boundary_;
+
+public:
+    DelaunayTriangulation() : n_(0), last_(0), walk_state_(0x9E3779B97F4A7C15ull) {}
+    
+    void build(const PointSet& points) {
+        n_ = points.size();
+        triangles_.clear();
+        free_.clear();
+        twin_.assign(n_, none);
+        last_copy_.resize(n_);
+        for (size_t i = 0; i < n_; ++i) last_copy_[i] = static_cast<uint32_t>(i);
+        copy_edges_.clear();
+        edge_start_.assign(n_ + 1, 0);
+        edge_to_.clear();
+        if (n_ == 0) return;
+        
+        // Cuantización sobre el cuadrado envolvente
+        auto [min_x, max_x] = std::minmax_element(points.xs.begin(), points.xs.end());
+        auto [min_y, max_y] = std::minmax_element(points.ys.begin(), points.ys.end());
+        double extent = std::max(*max_x - *min_x, *max_y - *min_y);
+        double scale = extent > 0 ? (grid_size - 1) / extent : 0.0;
+        qx_.resize(n_ + 3);
+        qy_.resize(n_ + 3);
+        for (size_t i = 0; i < n_; ++i) {
+            qx_[i] = std::llround((points.xs[i] - *min_x) * scale);
+            qy_[i] = std::llround((points.ys[i] - *min_y) * scale);
+        }
+        uint32_t s0 = static_cast<uint32_t>(n_), s1 = s0 + 1, s2 = s0 + 2;
+        qx_[s0] = super_low;  qy_[s0] = super_low;
+        qx_[s1] = super_high; qy_[s1] = super_low;
+        qx_[s2] = super_low;  qy_[s2] = super_high;
+        
+        triangles_.reserve(2 * n_ + 8);
+        last_ = new_triangle(s0, s1, s2);
+        for (uint32_t p : hilbert_order(points)) insert(p);
+        
+        // Aristas entre puntos reales: cada arista interior aparece en dos
+        // triángulos con sentidos opuestos; se toma el sentido u < v
+        std::vector<std::pair<uint32_t, uint32_t>> edges;
+        edges.reserve(3 * n_);
+        for (const Triangle& t : triangles_) {
+            if (!t.alive) continue;
+            for (int i = 0; i < 3; ++i) {
+                uint32_t u = t.v[i], v = t.v[(i + 1) % 3];
+                if (u < v && v < n_) edges.push_back({u, v});
+            }
+        }
+        for (const auto& e : copy_edges_) edges.push_back({std::min(e.first, e.second), std::max(e.first, e.second)});
+        
+        for (const auto& e : edges) {
+            edge_start_[e.first + 1]++;
+            edge_start_[e.second + 1]++;
+        }
+        for (size_t i = 0; i < n_; ++i) edge_start_[i + 1] += edge_start_[i];
+        edge_to_.resize(edge_start_[n_]);
+        std::vector<uint32_t> fill(edge_start_.begin(), edge_start_.end() - 1);
+        for (const auto& e : edges) {
+            edge_to_[fill[e.first]++] = e.second;
+            edge_to_[fill[e.second]++] = e.first;
+        }
+    }
+    
+    size_t size() const { return n_; }
+    size_t num_edges() const { return edge_to_.size() / 2; }
+    
+    // Vecinos de Delaunay de una ciudad (sin orden)
+    CandidateLists::Range neighbors(uint32_t city) const {
+        return {edge_to_.data() + edge_start_[city], edge_to_.data() + edge_start_[city + 1]};
+    }
+    
+    // Listas de candidatos con los vecinos de Delaunay de cada ciudad,
+    // ordenados por distancia; un duplicado agrega además los vecinos de su
+    // gemelo. max_per_city > 0 recorta las listas (0: sin límite).
+    void to_candidates(const PointSet& points, CandidateLists& candidates, size_t max_per_city = 0) const {
+        std::vector<std::vector<uint32_t>> lists(n_);
+        size_t k = 0;
+        for (uint32_t c = 0; c < n_; ++c) {
+            std::vector<uint32_t>& list = lists[c];
+            for (uint32_t v : neighbors(c)) list.push_back(v);
+            if (twin_[c] != none) {
+                for (uint32_t v : neighbors(twin_[c])) {
+                    if (v != c && std::find(list.begin(), list.end(), v) == list.end()) list.push_back(v);
+                }
+            }
+            std::sort(list.begin(), list.end(), [&](uint32_t a, uint32_t b) {
+                return distance_squared(points, c, a) < distance_squared(points, c, b);
+            });
+            if (max_per_city > 0 && list.size() > max_per_city) list.resize(max_per_city);
+            k = std::max(k, list.size());
+        }
+        
+        candidates.k = k;
+        candidates.neighbors.assign(n_ * k, 0);
+        candidates.counts.assign(n_, 0);
+        candidates.nodes_visited = 0;
+        for (uint32_t c = 0; c < n_; ++c) {
+            std::copy(lists[c].begin(), lists[c].end(), candidates.neighbors.begin() + static_cast<size_t>(c) * k);
+            candidates.counts[c] = static_cast<uint32_t>(lists[c].size());
+        }
+    }
+};
@@ -0,0 +1,61 @@
+#pragma once
+#include "point.h"
+#include <vector>
+#include <cstdint>
+
+// Longitudes de las aristas del tour indexadas por adyacencia: para cada ciudad
+// se guardan sus dos vecinos actuales y la longitud de cada arista. Como no
+// depende de posiciones ni de la orientación, reversar un segmento no la
+// invalida; un movimiento 2-opt solo cambia los cuatro extremos (O(1)).
+// Sirve igual para Tour y TwoLevelTour. Así la ganancia de un candidato solo
+// necesita calcular las dos aristas nuevas.
+struct EdgeCache {
+    std::vector<uint32_t> adj;   // adj[2c], adj[2c + 1]: vecinos de c en el tour
+    std::vector<double> len;     // Longitud de la arista (c, adj[2c + s])
+    
+    template <class TourT>
+    void build(const PointSet& points, const TourT& tour) {
+        size_t n = tour.size();
+        adj.assign(2 * n, 0);
+        len.assign(2 * n, 0.0);
+        for (uint32_t c = 0; c < n; ++c) {
+            uint32_t next = tour.next(c), prev = tour.prev(c);
+            adj[2 * c] = next;
+            adj[2 * c + 1] = prev;
+            len[2 * c] = distance(points, c, next);
+            len[2 * c + 1] = distance(points, c, prev);
+        }
+    }
+    
+    // Longitud de la arista (a, b) del tour actual; b debe ser vecino de a
+    double length(uint32_t a, uint32_t b) const {
+        return adj[2 * a] == b ? len[2 * a] : len[2 * a + 1];
+    }
+    
+    // En la lista de `city` cambia el vecino old_neighbor por new_neighbor
+    void replace(uint32_t city, uint32_t old_neighbor, uint32_t new_neighbor, double length) {
+        size_t slot = adj[2 * city] == old_neighbor ? 2 * city : 2 * city + 1;
+        adj[slot] = new_neighbor;
+        len[slot] = length;
+    }
+    
+    // Registra make_2opt_move(a, b, c, d): elimina (a, b) y (c, d), agrega
+    // (a, c) y (b, d) con las longitudes nuevas ya calculadas
+    void apply_2opt(uint32_t a, uint32_t b, uint32_t c, uint32_t d, double d_ac, double d_bd) {
+        replace(a, b, c, d_ac);
+        replace(c, d, a, d_ac);
+        replace(b, a, d, d_bd);
+        replace(d, c, b, d_bd);
+    }
+    
+    // Recalcula las dos aristas de `city` a partir del tour (tras movimientos
+    // compuestos como Or-opt)
+    template <class TourT>
+    void refresh(const PointSet& points, const TourT& tour, uint32_t city) {
+        uint32_t next = tour.next(city), prev = tour.prev(city);
+        adj[2 * city] = next;
+        adj[2 * city + 1] = prev;
+        len[2 * city] = distance(points, city, next);
+        len[2 * city + 1] = distance(points, city, prev);
+    }
+};
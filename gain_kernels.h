@@ -0,0 +1,208 @@
+#pragma once
+#include "point.h"
+#include "tour.h"
+#include <vector>
+#include <cmath>
+#include <cstddef>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define TSP_X86_KERNELS 1
+#endif
+
+// =============== KERNELS DE GANANCIA 2-OPT POR BLOQUES ===============
+// Para la búsqueda exhaustiva: con i fijo se evalúan las ganancias contra un
+// bloque contiguo de j (4 carriles con AVX2, 8 con AVX-512) sobre coordenadas
+// en orden de tour (SoA). La longitud de cada arista del tour se precalcula una
+// vez por pasada, de modo que cada par (i, j) cuesta dos raíces (las aristas
+// nuevas) y ninguna operación de módulo. El kernel se elige en tiempo de
+// ejecución con __builtin_cpu_supports; sin soporte se usa el bucle escalar.
+
+// Coordenadas en orden de tour con la primera ciudad repetida al final
+// (xs[n] = xs[0]) para que la arista (j, j + 1) nunca necesite módulo.
+// len[k] es la longitud de la arista (tour[k], tour[k + 1]).
+struct TourCoords {
+    std::vector<double> xs, ys, len;
+    
+    void assign(const PointSet& points, const Tour& tour) {
+        size_t n = tour.size();
+        xs.resize(n + 1);
+        ys.resize(n + 1);
+        len.resize(n);
+        for (size_t k = 0; k < n; ++k) {
+            xs[k] = points.xs[tour[k]];
+            ys[k] = points.ys[tour[k]];
+        }
+        xs[n] = xs[0];
+        ys[n] = ys[0];
+        for (size_t k = 0; k < n; ++k) {
+            double dx = xs[k + 1] - xs[k];
+            double dy = ys[k + 1] - ys[k];
+            len[k] = std::sqrt(dx * dx + dy * dy);
+        }
+    }
+};
+
+enum class GainKernel { Scalar, AVX2, AVX512 };
+
+inline const char* gain_kernel_name(GainKernel kernel) {
+    switch (kernel) {
+        case GainKernel::AVX512: return "AVX-512";
+        case GainKernel::AVX2: return "AVX2";
+        default: return "escalar";
+    }
+}
+
+// Mejor kernel soportado por la CPU (se detecta una sola vez)
+inline GainKernel detect_gain_kernel() {
+    static const GainKernel kernel = [] {
+#ifdef TSP_X86_KERNELS
+        __builtin_cpu_init();
+        if (__builtin_cpu_supports("avx512f")) return GainKernel::AVX512;
+        if (__builtin_cpu_supports("avx2")) return GainKernel::AVX2;
+#endif
+        return GainKernel::Scalar;
+    }();
+    return kernel;
+}
+
+// Todos los kernels recorren j en [begin, end) con i fijo y actualizan
+// (best_gain, best_j) solo ante una ganancia estrictamente mayor; entre
+// ganancias iguales conservan el j menor, igual que el bucle escalar.
+inline void best_2opt_in_row_scalar(const TourCoords& tc, size_t i, size_t begin, size_t end,
+                                    double& best_gain, size_t& best_j) {
+    const double* xs = tc.xs.data();
+    const double* ys = tc.ys.data();
+    const double* len = tc.len.data();
+    double ax = xs[i], ay = ys[i], bx = xs[i + 1], by = ys[i + 1];
+    
+    for (size_t j = begin; j < end; ++j) {
+        double acx = ax - xs[j], acy = ay - ys[j];
+        double bdx = bx - xs[j + 1], bdy = by - ys[j + 1];
+        double gain = len[i] + len[j] - std::sqrt(acx * acx + acy * acy)
+                                      - std::sqrt(bdx * bdx + bdy * bdy);
+        if (gain > best_gain) {
+            best_gain = gain;
+            best_j = j;
+        }
+    }
+}
+
+#ifdef TSP_X86_KERNELS
+__attribute__((target("avx2")))
+inline void best_2opt_in_row_avx2(const TourCoords& tc, size_t i, size_t begin, size_t end,
+                                  double& best_gain, size_t& best_j) {
+    const double* xs = tc.xs.data();
+    const double* ys = tc.ys.data();
+    const double* len = tc.len.data();
+    __m256d ax = _mm256_set1_pd(xs[i]), ay = _mm256_set1_pd(ys[i]);
+    __m256d bx = _mm256_set1_pd(xs[i + 1]), by = _mm256_set1_pd(ys[i + 1]);
+    __m256d len_i = _mm256_set1_pd(len[i]);
+    
+    // Mejor ganancia y su j por carril (j como double: exacto hasta 2^53)
+    __m256d lane_best = _mm256_set1_pd(best_gain);
+    __m256d lane_j = _mm256_set1_pd(-1.0);
+    __m256d js = _mm256_setr_pd(0.0, 1.0, 2.0, 3.0);
+    js = _mm256_add_pd(js, _mm256_set1_pd(static_cast<double>(begin)));
+    const __m256d step = _mm256_set1_pd(4.0);
+    
+    size_t j = begin;
+    for (; j + 4 <= end; j += 4) {
+        __m256d acx = _mm256_sub_pd(ax, _mm256_loadu_pd(xs + j));
+        __m256d acy = _mm256_sub_pd(ay, _mm256_loadu_pd(ys + j));
+        __m256d bdx = _mm256_sub_pd(bx, _mm256_loadu_pd(xs + j + 1));
+        __m256d bdy = _mm256_sub_pd(by, _mm256_loadu_pd(ys + j + 1));
+        __m256d ac = _mm256_sqrt_pd(_mm256_add_pd(_mm256_mul_pd(acx, acx), _mm256_mul_pd(acy, acy)));
+        __m256d bd = _mm256_sqrt_pd(_mm256_add_pd(_mm256_mul_pd(bdx, bdx), _mm256_mul_pd(bdy, bdy)));
+        __m256d gain = _mm256_sub_pd(_mm256_add_pd(len_i, _mm256_loadu_pd(len + j)),
+                                     _mm256_add_pd(ac, bd));
+        
+        __m256d better = _mm256_cmp_pd(gain, lane_best, _CMP_GT_OQ);
+        lane_best = _mm256_blendv_pd(lane_best, gain, better);
+        lane_j = _mm256_blendv_pd(lane_j, js, better);
+        js = _mm256_add_pd(js, step);
+    }
+    
+    // Reducción entre carriles: mayor ganancia, y ante empate el j menor
+    alignas(32) double gains[4], indices[4];
+    _mm256_store_pd(gains, lane_best);
+    _mm256_store_pd(indices, lane_j);
+    for (int lane = 0; lane < 4; ++lane) {
+        if (indices[lane] < 0) continue;
+        size_t lane_best_j = static_cast<size_t>(indices[lane]);
+        if (gains[lane] > best_gain || (gains[lane] == best_gain && lane_best_j < best_j)) {
+            best_gain = gains[lane];
+            best_j = lane_best_j;
+        }
+    }
+    
+    best_2opt_in_row_scalar(tc, i, j, end, best_gain, best_j);
+}
+
+__attribute__((target("avx512f")))
+inline void best_2opt_in_row_avx512(const TourCoords& tc, size_t i, size_t begin, size_t end,
+                                    double& best_gain, size_t& best_j) {
+    const double* xs = tc.xs.data();
+    const double* ys = tc.ys.data();
+    const double* len = tc.len.data();
+    __m512d ax = _mm512_set1_pd(xs[i]), ay = _mm512_set1_pd(ys[i]);
+    __m512d bx = _mm512_set1_pd(xs[i + 1]), by = _mm512_set1_pd(ys[i + 1]);
+    __m512d len_i = _mm512_set1_pd(len[i]);
+    
+    __m512d lane_best = _mm512_set1_pd(best_gain);
+    __m512d lane_j = _mm512_set1_pd(-1.0);
+    __m512d js = _mm512_setr_pd(0.0, 1.0, 2.0, 3.0, 4.0, 5.0, 6.0, 7.0);
+    js = _mm512_add_pd(js, _mm512_set1_pd(static_cast<double>(begin)));
+    const __m512d step = _mm512_set1_pd(8.0);
+    
+    size_t j = begin;
+    for (; j + 8 <= end; j += 8) {
+        __m512d acx = _mm512_sub_pd(ax, _mm512_loadu_pd(xs + j));
+        __m512d acy = _mm512_sub_pd(ay, _mm512_loadu_pd(ys + j));
+        __m512d bdx = _mm512_sub_pd(bx, _mm512_loadu_pd(xs + j + 1));
+        __m512d bdy = _mm512_sub_pd(by, _mm512_loadu_pd(ys + j + 1));
+        // maskz con todos los carriles activos: evita el operando indefinido de
+        // _mm512_sqrt_pd (falso -Wmaybe-uninitialized en GCC 12)
+        __m512d ac = _mm512_maskz_sqrt_pd(0xFF, _mm512_add_pd(_mm512_mul_pd(acx, acx), _mm512_mul_pd(acy, acy)));
+        __m512d bd = _mm512_maskz_sqrt_pd(0xFF, _mm512_add_pd(_mm512_mul_pd(bdx, bdx), _mm512_mul_pd(bdy, bdy)));
+        __m512d gain = _mm512_sub_pd(_mm512_add_pd(len_i, _mm512_loadu_pd(len + j)),
+                                     _mm512_add_pd(ac, bd));
+        
+        __mmask8 better = _mm512_cmp_pd_mask(gain, lane_best, _CMP_GT_OQ);
+        lane_best = _mm512_mask_blend_pd(better, lane_best, gain);
+        lane_j = _mm512_mask_blend_pd(better, lane_j, js);
+        js = _mm512_add_pd(js, step);
+    }
+    
+    alignas(64) double gains[8], indices[8];
+    _mm512_store_pd(gains, lane_best);
+    _mm512_store_pd(indices, lane_j);
+    for (int lane = 0; lane < 8; ++lane) {
+        if (indices[lane] < 0) continue;
+        size_t lane_best_j = static_cast<size_t>(indices[lane]);
+        if (gains[lane] > best_gain || (gains[lane] == best_gain && lane_best_j < best_j)) {
+            best_gain = gains[lane];
+            best_j = lane_best_j;
+        }
+    }
+    
+    best_2opt_in_row_scalar(tc, i, j, end, best_gain, best_j);
+}
+#endif
+
+// Mejor j en [begin, end) para el i dado con el kernel indicado
+inline void best_2opt_in_row(GainKernel kernel, const TourCoords& tc, size_t i,
+                             size_t begin, size_t end, double& best_gain, size_t& best_j) {
+#ifdef TSP_X86_KERNELS
+    if (kernel == GainKernel::AVX512) {
+        best_2opt_in_row_avx512(tc, i, begin, end, best_gain, best_j);
+        return;
+    }
+    if (kernel == GainKernel::AVX2) {
+        best_2opt_in_row_avx2(tc, i, begin, end, best_gain, best_j);
+        return;
+    }
+#endif
+    (void)kernel;
+    best_2opt_in_row_scalar(tc, i, begin, end, best_gain, best_j);
+}
@@ -0,0 +1,247 @@
+#pragma once
+#include "point.h"
+#include <vector>
+#include <queue>
+#include <limits>
+#include <algorithm>
+#include <cmath>
+
+// Grilla uniforme (spatial hash) sobre un PointSet, con la misma interfaz de
+// consultas que KDTree. El lado de celda se deriva de la densidad: el área de
+// la caja envolvente repartida en celdas de ~points_per_cell puntos.
+// Los puntos se guardan por celda en formato CSR (cell_start_) con celdas en
+// orden de filas, de modo que un tramo de celdas consecutivas de una fila es
+// un rango contiguo de xs_/ys_ que se recorre con un bucle vectorizable.
+// En instancias casi uniformes evita la profundidad del K-d tree; con puntos
+// muy agrupados muchas celdas quedan vacías y las consultas K-NN recorren más
+// anillos, terreno donde el K-d tree vuelve a ganar (ver --bench-index).
+class GridIndex {
+public:
+    static constexpr double default_points_per_cell = 2.0;
+
+private:
+    static constexpr size_t scan_chunk = 64;
+    
+    std::vector<double> xs_, ys_;          // Coordenadas agrupadas por celda
+    std::vector<uint32_t> index_;          // Índice de cada punto en el PointSet
+    std::vector<uint32_t> cell_start_;     // Puntos de la celda c: [cell_start_[c], cell_start_[c + 1])
+    double min_x_, min_y_;
+    double cell_size_, inv_cell_size_;
+    size_t cols_, rows_;
+    double points_per_cell_;
+    size_t size_;
+    mutable size_t nodes_visited; // Para métricas (celdas visitadas)
+    
+    size_t cell_x(double x) const {
+        double c = std::floor((x - min_x_) * inv_cell_size_);
+        if (c < 0) return 0;
+        return std::min(static_cast<size_t>(c), cols_ - 1);
+    }
+    
+    size_t cell_y(double y) const {
+        double c = std::floor((y - min_y_) * inv_cell_size_);
+        if (c < 0) return 0;
+        return std::min(static_cast<size_t>(c), rows_ - 1);
+    }
+    
+    // Recorre las celdas [x0, x1] de la fila `row` (rango contiguo de puntos)
+    // llamando a visit(dist_sq, i) con i la posición interna del punto
+    template <class Visit>
+    void scan_row(size_t row, size_t x0, size_t x1, const Point& query, Visit&& visit) const {
+        nodes_visited += x1 - x0 + 1;
+        size_t begin = cell_start_[row * cols_ + x0];
+        size_t end = cell_start_[row * cols_ + x1 + 1];
+        double qx = query.x, qy = query.y;
+        
+        alignas(64) double dist_sq[scan_chunk];
+        for (size_t base = begin; base < end; base += scan_chunk) {
+            size_t count = std::min(scan_chunk, end - base);
+            const double* xs = xs_.data() + base;
+            const double* ys = ys_.data() + base;
+            for (size_t i = 0; i < count; ++i) {
+                double dx = xs[i] - qx;
+                double dy = ys[i] - qy;
+                dist_sq[i] = dx * dx + dy * dy;
+            }
+            for (size_t i = 0; i < count; ++i) visit(dist_sq[i], base + i);
+        }
+    }
+    
+    // Búsqueda por anillos de celdas alrededor de la consulta. Tras cada anillo
+    // llama a done(bound_sq), donde bound_sq acota por debajo la distancia al
+    // cuadrado a cualquier punto aún no visitado; se detiene si done devuelve
+    // true o cuando los anillos cubren toda la grilla.
+    template <class Visit, class Done>
+    void ring_search(const Point& query, Visit&& visit, Done&& done) const {
+        const double inf = std::numeric_limits<double>::max();
+        long cx = static_cast<long>(cell_x(query.x));
+        long cy = static_cast<long>(cell_y(query.y));
+        long cols = static_cast<long>(cols_), rows = static_cast<long>(rows_);
+        
+        for (long r = 0; ; ++r) {
+            long x0 = std::max(cx - r, 0L), x1 = std::min(cx + r, cols - 1);
+            long y0 = std::max(cy - r, 0L), y1 = std::min(cy + r, rows - 1);
+            
+            // Filas superior e inferior del anillo completas, columnas laterales sin esquinas
+            if (cy - r >= 0) scan_row(cy - r, x0, x1, query, visit);
+            if (r > 0 && cy + r < rows) scan_row(cy + r, x0, x1, query, visit);
+            for (long y = std::max(cy - r + 1, 0L); y <= std::min(cy + r - 1, rows - 1); ++y) {
+                if (r > 0 && cx - r >= 0) scan_row(y, cx - r, cx - r, query, visit);
+                if (r > 0 && cx + r < cols) scan_row(y, cx + r, cx + r, query, visit);
+            }
+            
+            bool covers_all = x0 == 0 && y0 == 0 && x1 == cols - 1 && y1 == rows - 1;
+            if (covers_all) return;
+            
+            // Distancia de la consulta al borde del cuadrado ya visitado (los lados
+            // que coinciden con el borde de la grilla no tienen puntos más allá)
+            double bound = inf;
+            if (cx - r > 0) bound = std::min(bound, query.x - (min_x_ + (cx - r) * cell_size_));
+            if (cx + r < cols - 1) bound = std::min(bound, min_x_ + (cx + r + 1) * cell_size_ - query.x);
+            if (cy - r > 0) bound = std::min(bound, query.y - (min_y_ + (cy - r) * cell_size_));
+            if (cy + r < rows - 1) bound = std::min(bound, min_y_ + (cy + r + 1) * cell_size_ - query.y);
+            
+            double bound_sq = bound <= 0 ? 0.0 : bound * bound;
+            if (done(bound_sq)) return;
+        }
+    }
+
+public:
+    explicit GridIndex(double points_per_cell = default_points_per_cell)
+        : min_x_(0), min_y_(0), cell_size_(1), inv_cell_size_(1), cols_(1), rows_(1),
+          points_per_cell_(points_per_cell > 0 ? points_per_cell : default_points_per_cell),
+          size_(0), nodes_visited(0) {}
+    
+    void build(const PointSet& points) {
+        if (points.empty()) return;
+        
+        size_t n = points.size();
+        auto [min_x, max_x] = std::minmax_element(points.xs.begin(), points.xs.end());
+        auto [min_y, max_y] = std::minmax_element(points.ys.begin(), points.ys.end());
+        min_x_ = *min_x;
+        min_y_ = *min_y;
+        double width = *max_x - min_x_, height = *max_y - min_y_;
+        
+        // Lado de celda según la densidad media; caja degenerada -> una sola fila/columna
+        double extent = std::max(width, height);
+        double area = std::max(width, extent * 1e-3) * std::max(height, extent * 1e-3);
+        cell_size_ = extent > 0 ? std::sqrt(area * points_per_cell_ / n) : 1.0;
+        inv_cell_size_ = 1.0 / cell_size_;
+        cols_ = static_cast<size_t>(width * inv_cell_size_) + 1;
+        rows_ = static_cast<size_t>(height * inv_cell_size_) + 1;
+        
+        // Ordenamiento por conteo de los puntos según su celda
+        size_t num_cells = cols_ * rows_;
+        std::vector<uint32_t> cell_of(n);
+        cell_start_.assign(num_cells + 1, 0);
+        for (size_t i = 0; i < n; ++i) {
+            cell_of[i] = static_cast<uint32_t>(cell_y(points.ys[i]) * cols_ + cell_x(points.xs[i]));
+            cell_start_[cell_of[i] + 1]++;
+        }
+        for (size_t c = 0; c < num_cells; ++c) cell_start_[c + 1] += cell_start_[c];
+        
+        std::vector<uint32_t> fill(cell_start_.begin(), cell_start_.end() - 1);
+        xs_.resize(n);
+        ys_.resize(n);
+        index_.resize(n);
+        for (size_t i = 0; i < n; ++i) {
+            uint32_t slot = fill[cell_of[i]]++;
+            xs_[slot] = points.xs[i];
+            ys_[slot] = points.ys[i];
+            index_[slot] = static_cast<uint32_t>(i);
+        }
+        size_ = n;
+        nodes_visited = 0;
+    }
+    
+    // FRNN con radio fijo
+    std::vector<uint32_t> find_neighbors(const Point& query, double radius) const {
+        std::vector<uint32_t> neighbors;
+        nodes_visited = 0;
+        if (size_ == 0) return neighbors;
+        
+        double radius_sq = radius * radius;
+        size_t x0 = cell_x(query.x - radius), x1 = cell_x(query.x + radius);
+        size_t y0 = cell_y(query.y - radius), y1 = cell_y(query.y + radius);
+        for (size_t row = y0; row <= y1; ++row) {
+            scan_row(row, x0, x1, query, [&](double dist_sq, size_t i) {
+                if (dist_sq <= radius_sq) neighbors.push_back(index_[i]);
+            });
+        }
+        return neighbors;
+    }
+    
+    // Encuentra el vecino más cercano (índice)
+    uint32_t find_nearest_neighbor(const Point& query) const {
+        return find_nearest_neighbor(query, std::vector<bool>());
+    }
+    
+    // Vecino más cercano ignorando los puntos con excluded[i] == true.
+    // Devuelve size() si todos están excluidos. Un vector vacío no excluye nada.
+    uint32_t find_nearest_neighbor(const Point& query, const std::vector<bool>& excluded) const {
+        uint32_t best = static_cast<uint32_t>(size_);
+        double best_dist_sq = std::numeric_limits<double>::max();
+        nodes_visited = 0;
+        if (size_ == 0) return 0;
+        
+        ring_search(query,
+            [&](double dist_sq, size_t i) {
+                if (dist_sq < best_dist_sq && (excluded.empty() || !excluded[index_[i]])) {
+                    best_dist_sq = dist_sq;
+                    best = index_[i];
+                }
+            },
+            [&](double bound_sq) { return best_dist_sq <= bound_sq; });
+        return best;
+    }
+    
+    // Encuentra los k vecinos más cercanos (índices)
+    std::vector<uint32_t> find_k_nearest_neighbors(const Point& query, size_t k) const {
+        std::priority_queue<std::pair<double, uint32_t>> best_k;
+        nodes_visited = 0;
+        
+        if (size_ > 0 && k > 0) {
+            ring_search(query,
+                [&](double dist_sq, size_t i) {
+                    if (best_k.size() < k) {
+                        best_k.push({dist_sq, index_[i]});
+                    } else if (dist_sq < best_k.top().first) {
+                        best_k.pop();
+                        best_k.push({dist_sq, index_[i]});
+                    }
+                },
+                [&](double bound_sq) { return best_k.size() == k && best_k.top().first <= bound_sq; });
+        }
+        
+        std::vector<uint32_t> result;
+        while (!best_k.empty()) {
+            result.push_back(best_k.top().second);
+            best_k.pop();
+        }
+        
+        std::reverse(result.begin(), result.end()); // Orden de más cercano a más lejano
+        return result;
+    }
+    
+    // FRNN adaptativo: ajusta el radio según la densidad local
+    std::vector<uint32_t> find_neighbors_adaptive(const Point& query, double base_radius, size_t min_neighbors = 5) const {
+        double radius = base_radius;
+        std::vector<uint32_t> neighbors;
+        
+        // Incrementar radio hasta encontrar suficientes vecinos
+        while (neighbors.size() < min_neighbors && radius < 2.0) {
+            neighbors = find_neighbors(query, radius);
+            if (neighbors.size() < min_neighbors) {
+                radius *= 1.5; // Incrementar radio
+            }
+        }
+        
+        return neighbors;
+    }
+    
+    size_t size() const { return size_; }
+    double cell_size() const { return cell_size_; }
+    size_t num_cells() const { return cols_ * rows_; }
+    size_t get_nodes_visited() const { return nodes_visited; }
+    void reset_nodes_visited() const { nodes_visited = 0; }
+};
@@ -1,183 +1,531 @@
 #pragma once
 #include "point.h"
 #include <vector>
-#include <memory>
 #include <queue>
 #include <limits>
-#include <unordered_map>
+#include <algorithm>
 
-class KDNode {
+// K-d tree implícito sobre un PointSet con hojas agrupadas en buckets.
+// Los puntos se guardan permutados en arreglos SoA (xs_, ys_, index_). El rango
+// [lo, hi) es una hoja si tiene como mucho leaf_size_ puntos; si no, es un nodo
+// interno cuyo punto de corte está en mid = (lo + hi) / 2 y sus hijos son los
+// rangos [lo, mid) y [mid + 1, hi). El eje se deduce de la profundidad (x en
+// niveles pares, y en impares), así que no hay punteros ni nodos explícitos.
+// Las hojas se recorren con un bucle contiguo que el compilador vectoriza.
+class KDTree {
 public:
-    Point point;
-    std::unique_ptr<KDNode> left;
-    std::unique_ptr<KDNode> right;
-    int depth;
+    static constexpr size_t default_leaf_size = 16;
+    static constexpr size_t max_leaf_size = 64;
     
-    KDNode(const Point& p, int d) : point(p), depth(d) {}
-};
+    // Conjunto de puntos vivos para consultas NN con borrado (heurística
+    // Nearest Neighbor). Vive fuera del árbol: el árbol sigue siendo const y
+    // cada construcción (o hilo) usa su propio AliveSet sobre el mismo árbol.
+    // count[id] es el número de puntos vivos del subárbol cuyo id es su punto
+    // de corte (nodos internos) o su primera posición (buckets); ambos son
+    // únicos, así que basta un arreglo de n contadores.
+    class AliveSet {
+        friend class KDTree;
+        std::vector<uint8_t> alive;      // Por posición en el árbol
+        std::vector<uint32_t> count;     // Vivos por subárbol (indexado por id)
+        size_t remaining = 0;
+        mutable size_t nodes_visited = 0;   // Métricas sin escribir en el árbol compartido
+    
+    public:
+        size_t size() const { return remaining; }
+        bool empty() const { return remaining == 0; }
+        size_t get_nodes_visited() const { return nodes_visited; }
+    };
 
-class KDTree {
 private:
-    std::unique_ptr<KDNode> root;
+    std::vector<double> xs_, ys_;      // Coordenadas en orden del árbol
+    std::vector<uint32_t> index_;      // Índice de cada punto en el PointSet
+    std::vector<uint32_t> position_;   // Posición en el árbol de cada punto (inversa de index_)
+    size_t leaf_size_;                 // Puntos por bucket (1..max_leaf_size)
     size_t size_;
-    mutable size_t nodes_visited; // Para métricas
+    double min_x_, min_y_, max_x_, max_y_;   // Caja envolvente de todos los puntos
+    mutable size_t nodes_visited; // Para métricas (nodos internos + buckets)
+    
+    bool is_leaf(size_t lo, size_t hi) const { return hi - lo <= leaf_size_; }
+    
+    double distance_sq_to(size_t i, const Point& query) const {
+        double dx = xs_[i] - query.x;
+        double dy = ys_[i] - query.y;
+        return dx * dx + dy * dy;
+    }
     
-    std::unique_ptr<KDNode> build(std::vector<Point>& points, int depth, size_t start, size_t end) {
-        if (start >= end) return nullptr;
+    // Distancias al cuadrado de todo el bucket [lo, hi) a la consulta (SIMD)
+    void bucket_distances(size_t lo, size_t hi, const Point& query, double* out) const {
+        const double* xs = xs_.data() + lo;
+        const double* ys = ys_.data() + lo;
+        size_t count = hi - lo;
+        double qx = query.x, qy = query.y;
+        for (size_t i = 0; i < count; ++i) {
+            double dx = xs[i] - qx;
+            double dy = ys[i] - qy;
+            out[i] = dx * dx + dy * dy;
+        }
+    }
+    
+    void build(const PointSet& points, std::vector<uint32_t>& order, size_t lo, size_t hi, int depth) {
+        if (is_leaf(lo, hi)) return;
         
-        size_t mid = (start + end) / 2;
+        size_t mid = (lo + hi) / 2;
         bool axis = depth % 2 == 0; // true para x, false para y
+        const std::vector<double>& c = axis ? points.xs : points.ys;
         
         // Ordenar puntos según el eje actual
-        std::nth_element(points.begin() + start, points.begin() + mid, points.begin() + end,
-            [axis](const Point& a, const Point& b) {
-                return axis ? a.x < b.x : a.y < b.y;
-            });
-        
-        auto node = std::make_unique<KDNode>(points[mid], depth);
-        node->left = build(points, depth + 1, start, mid);
-        node->right = build(points, depth + 1, mid + 1, end);
+        std::nth_element(order.begin() + lo, order.begin() + mid, order.begin() + hi,
+            [&c](uint32_t a, uint32_t b) { return c[a] < c[b]; });
         
-        return node;
+        build(points, order, lo, mid, depth + 1);
+        build(points, order, mid + 1, hi, depth + 1);
     }
     
     // FRNN optimizado con radio dinámico
-    void find_neighbors_frnn(const KDNode* node, const Point& query, double radius,
-                            std::vector<Point>& neighbors) const {
-        if (!node) return;
+    void find_neighbors_frnn(size_t lo, size_t hi, int depth, const Point& query, double radius,
+                            std::vector<uint32_t>& neighbors) const {
+        if (lo >= hi) return;
         
         nodes_visited++;
+        double radius_sq = radius * radius;
+        
+        if (is_leaf(lo, hi)) {
+            alignas(64) double dist_sq[max_leaf_size];
+            bucket_distances(lo, hi, query, dist_sq);
+            for (size_t i = 0; i < hi - lo; ++i) {
+                if (dist_sq[i] <= radius_sq) neighbors.push_back(index_[lo + i]);
+            }
+            return;
+        }
         
-        // Verificar si el nodo actual está dentro del radio
-        double dist_sq = distance_squared(node->point, query);
-        if (dist_sq <= radius * radius) {
-            neighbors.push_back(node->point);
+        // Verificar si el punto de corte está dentro del radio
+        size_t mid = (lo + hi) / 2;
+        if (distance_sq_to(mid, query) <= radius_sq) {
+            neighbors.push_back(index_[mid]);
         }
         
         // Determinar qué hijo explorar primero
-        bool axis = node->depth % 2 == 0;
-        double diff = axis ? query.x - node->point.x : query.y - node->point.y;
+        bool axis = depth % 2 == 0;
+        double diff = axis ? query.x - xs_[mid] : query.y - ys_[mid];
         
         // Explorar el lado más probable primero
         if (diff <= 0) {
-            find_neighbors_frnn(node->left.get(), query, radius, neighbors);
-            if (diff * diff <= radius * radius) {
-                find_neighbors_frnn(node->right.get(), query, radius, neighbors);
+            find_neighbors_frnn(lo, mid, depth + 1, query, radius, neighbors);
+            if (diff * diff <= radius_sq) {
+                find_neighbors_frnn(mid + 1, hi, depth + 1, query, radius, neighbors);
             }
         } else {
-            find_neighbors_frnn(node->right.get(), query, radius, neighbors);
-            if (diff * diff <= radius * radius) {
-                find_neighbors_frnn(node->left.get(), query, radius, neighbors);
+            find_neighbors_frnn(mid + 1, hi, depth + 1, query, radius, neighbors);
+            if (diff * diff <= radius_sq) {
+                find_neighbors_frnn(lo, mid, depth + 1, query, radius, neighbors);
             }
         }
     }
     
-    // Búsqueda del vecino más cercano (para heurística NN)
-    void find_nearest(const KDNode* node, const Point& query, Point& best, double& best_dist_sq) const {
-        if (!node) return;
+    // Búsqueda del vecino más cercano (para heurística NN); los puntos marcados
+    // en `excluded` (si no es nulo) se ignoran
+    void find_nearest(size_t lo, size_t hi, int depth, const Point& query,
+                      const std::vector<bool>* excluded,
+                      uint32_t& best, double& best_dist_sq) const {
+        if (lo >= hi) return;
         
         nodes_visited++;
         
-        double dist_sq = distance_squared(node->point, query);
-        if (dist_sq < best_dist_sq) {
+        if (is_leaf(lo, hi)) {
+            alignas(64) double dist_sq[max_leaf_size];
+            bucket_distances(lo, hi, query, dist_sq);
+            for (size_t i = 0; i < hi - lo; ++i) {
+                if (dist_sq[i] < best_dist_sq && !(excluded && (*excluded)[index_[lo + i]])) {
+                    best_dist_sq = dist_sq[i];
+                    best = index_[lo + i];
+                }
+            }
+            return;
+        }
+        
+        size_t mid = (lo + hi) / 2;
+        double dist_sq = distance_sq_to(mid, query);
+        if (dist_sq < best_dist_sq && !(excluded && (*excluded)[index_[mid]])) {
             best_dist_sq = dist_sq;
-            best = node->point;
+            best = index_[mid];
         }
         
-        bool axis = node->depth % 2 == 0;
-        double diff = axis ? query.x - node->point.x : query.y - node->point.y;
+        bool axis = depth % 2 == 0;
+        double diff = axis ? query.x - xs_[mid] : query.y - ys_[mid];
         
         // Explorar el lado más probable primero
         if (diff <= 0) {
-            find_nearest(node->left.get(), query, best, best_dist_sq);
+            find_nearest(lo, mid, depth + 1, query, excluded, best, best_dist_sq);
             if (diff * diff < best_dist_sq) {
-                find_nearest(node->right.get(), query, best, best_dist_sq);
+                find_nearest(mid + 1, hi, depth + 1, query, excluded, best, best_dist_sq);
             }
         } else {
-            find_nearest(node->right.get(), query, best, best_dist_sq);
+            find_nearest(mid + 1, hi, depth + 1, query, excluded, best, best_dist_sq);
             if (diff * diff < best_dist_sq) {
-                find_nearest(node->left.get(), query, best, best_dist_sq);
+                find_nearest(lo, mid, depth + 1, query, excluded, best, best_dist_sq);
             }
         }
     }
     
-    // K vecinos más cercanos
-    void find_k_nearest(const KDNode* node, const Point& query, size_t k,
-                       std::priority_queue<std::pair<double, Point>>& best_k) const {
-        if (!node) return;
+    // Vecino más cercano entre los puntos vivos: se podan los subárboles sin
+    // vivos y, ante distancias iguales, gana el menor índice (igual que el
+    // recorrido por fuerza bruta de nearest_neighbor_tour). Por eso el lado
+    // lejano se visita también cuando diff^2 == best_dist_sq.
+    void find_nearest_alive(size_t lo, size_t hi, int depth, const Point& query, const AliveSet& set,
+                            uint32_t& best, double& best_dist_sq) const {
+        if (lo >= hi) return;
         
-        nodes_visited++;
+        auto offer_alive = [&](size_t pos, double dist_sq) {
+            if (set.alive[pos] && (dist_sq < best_dist_sq || (dist_sq == best_dist_sq && index_[pos] < best))) {
+                best_dist_sq = dist_sq;
+                best = index_[pos];
+            }
+        };
+        
+        if (is_leaf(lo, hi)) {
+            if (set.count[lo] == 0) return;
+            set.nodes_visited++;
+            alignas(64) double dist_sq[max_leaf_size];
+            bucket_distances(lo, hi, query, dist_sq);
+            for (size_t i = 0; i < hi - lo; ++i) offer_alive(lo + i, dist_sq[i]);
+            return;
+        }
+        
+        size_t mid = (lo + hi) / 2;
+        if (set.count[mid] == 0) return;
+        set.nodes_visited++;
+        offer_alive(mid, distance_sq_to(mid, query));
+        
+        bool axis = depth % 2 == 0;
+        double diff = axis ? query.x - xs_[mid] : query.y - ys_[mid];
+        
+        if (diff <= 0) {
+            find_nearest_alive(lo, mid, depth + 1, query, set, best, best_dist_sq);
+            if (diff * diff <= best_dist_sq) {
+                find_nearest_alive(mid + 1, hi, depth + 1, query, set, best, best_dist_sq);
+            }
+        } else {
+            find_nearest_alive(mid + 1, hi, depth + 1, query, set, best, best_dist_sq);
+            if (diff * diff <= best_dist_sq) {
+                find_nearest_alive(lo, mid, depth + 1, query, set, best, best_dist_sq);
+            }
+        }
+    }
+    
+    // K vecinos vivos más cercanos (misma poda por subárboles sin vivos)
+    void find_k_nearest_alive(size_t lo, size_t hi, int depth, const Point& query, size_t k,
+                              const AliveSet& set,
+                              std::priority_queue<std::pair<double, uint32_t>>& best_k) const {
+        if (lo >= hi) return;
+        
+        if (is_leaf(lo, hi)) {
+            if (set.count[lo] == 0) return;
+            set.nodes_visited++;
+            alignas(64) double dist_sq[max_leaf_size];
+            bucket_distances(lo, hi, query, dist_sq);
+            for (size_t i = 0; i < hi - lo; ++i) {
+                if (set.alive[lo + i]) offer(best_k, k, dist_sq[i], index_[lo + i]);
+            }
+            return;
+        }
+        
+        size_t mid = (lo + hi) / 2;
+        if (set.count[mid] == 0) return;
+        set.nodes_visited++;
+        if (set.alive[mid]) offer(best_k, k, distance_sq_to(mid, query), index_[mid]);
         
-        double dist_sq = distance_squared(node->point, query);
+        bool axis = depth % 2 == 0;
+        double diff = axis ? query.x - xs_[mid] : query.y - ys_[mid];
+        size_t near_lo = diff <= 0 ? lo : mid + 1, near_hi = diff <= 0 ? mid : hi;
+        size_t far_lo = diff <= 0 ? mid + 1 : lo, far_hi = diff <= 0 ? hi : mid;
         
+        find_k_nearest_alive(near_lo, near_hi, depth + 1, query, k, set, best_k);
+        double worst_dist = best_k.size() < k ? std::numeric_limits<double>::max() : best_k.top().first;
+        if (diff * diff < worst_dist) {
+            find_k_nearest_alive(far_lo, far_hi, depth + 1, query, k, set, best_k);
+        }
+    }
+    
+    // Inicializa los contadores del subárbol [lo, hi): todos vivos o ninguno
+    void fill_alive_counts(size_t lo, size_t hi, AliveSet& set, bool alive) const {
+        if (lo >= hi) return;
+        if (is_leaf(lo, hi)) {
+            set.count[lo] = alive ? static_cast<uint32_t>(hi - lo) : 0;
+            return;
+        }
+        size_t mid = (lo + hi) / 2;
+        set.count[mid] = alive ? static_cast<uint32_t>(hi - lo) : 0;
+        fill_alive_counts(lo, mid, set, alive);
+        fill_alive_counts(mid + 1, hi, set, alive);
+    }
+    
+    static void offer(std::priority_queue<std::pair<double, uint32_t>>& best_k, size_t k,
+                      double dist_sq, uint32_t index) {
         if (best_k.size() < k) {
-            best_k.push({dist_sq, node->point});
+            best_k.push({dist_sq, index});
         } else if (dist_sq < best_k.top().first) {
             best_k.pop();
-            best_k.push({dist_sq, node->point});
+            best_k.push({dist_sq, index});
         }
+    }
+    
+    // K vecinos más cercanos
+    void find_k_nearest(size_t lo, size_t hi, int depth, const Point& query, size_t k,
+                       std::priority_queue<std::pair<double, uint32_t>>& best_k) const {
+        if (lo >= hi) return;
         
-        bool axis = node->depth % 2 == 0;
-        double diff = axis ? query.x - node->point.x : query.y - node->point.y;
+        nodes_visited++;
         
-        double worst_dist = best_k.size() < k ? std::numeric_limits<double>::max() : best_k.top().first;
+        if (is_leaf(lo, hi)) {
+            alignas(64) double dist_sq[max_leaf_size];
+            bucket_distances(lo, hi, query, dist_sq);
+            for (size_t i = 0; i < hi - lo; ++i) {
+                offer(best_k, k, dist_sq[i], index_[lo + i]);
+            }
+            return;
+        }
+        
+        size_t mid = (lo + hi) / 2;
+        offer(best_k, k, distance_sq_to(mid, query), index_[mid]);
+        
+        bool axis = depth % 2 == 0;
+        double diff = axis ? query.x - xs_[mid] : query.y - ys_[mid];
+        
+        double worst_dist;
         
         // Explorar el lado más probable primero
         if (diff <= 0) {
-            find_k_nearest(node->left.get(), query, k, best_k);
+            find_k_nearest(lo, mid, depth + 1, query, k, best_k);
             worst_dist = best_k.size() < k ? std::numeric_limits<double>::max() : best_k.top().first;
             if (diff * diff < worst_dist) {
-                find_k_nearest(node->right.get(), query, k, best_k);
+                find_k_nearest(mid + 1, hi, depth + 1, query, k, best_k);
             }
         } else {
-            find_k_nearest(node->right.get(), query, k, best_k);
+            find_k_nearest(mid + 1, hi, depth + 1, query, k, best_k);
             worst_dist = best_k.size() < k ? std::numeric_limits<double>::max() : best_k.top().first;
             if (diff * diff < worst_dist) {
-                find_k_nearest(node->left.get(), query, k, best_k);
+                find_k_nearest(lo, mid, depth + 1, query, k, best_k);
+            }
+        }
+    }
+    
+    // Caja de un subárbol: se deriva de los cortes de sus ancestros, sin guardarla
+    struct Box {
+        double min_x, min_y, max_x, max_y;
+    };
+    
+    // Cuadrante de un punto relativo a la consulta: 0 = (+x, +y), 1 = (-x, +y),
+    // 2 = (+x, -y), 3 = (-x, -y); los puntos sobre un eje van al lado positivo
+    static int quadrant_of(double dx, double dy) {
+        return (dx < 0 ? 1 : 0) + (dy < 0 ? 2 : 0);
+    }
+    
+    // ¿Puede la caja aportar un punto a algún cuadrante? Sí si corta el
+    // cuadrante y su parte dentro de él está más cerca que el peor de ese heap
+    // (o el heap aún no tiene k puntos)
+    static bool box_needed(const Box& box, const Point& query, size_t k,
+                           const std::priority_queue<std::pair<double, uint32_t>>* best) {
+        for (int q = 0; q < 4; ++q) {
+            double lo_x = (q & 1) ? box.min_x : std::max(box.min_x, query.x);
+            double hi_x = (q & 1) ? std::min(box.max_x, query.x) : box.max_x;
+            double lo_y = (q & 2) ? box.min_y : std::max(box.min_y, query.y);
+            double hi_y = (q & 2) ? std::min(box.max_y, query.y) : box.max_y;
+            if (lo_x > hi_x || lo_y > hi_y) continue;
+            if (best[q].size() < k) return true;
+            double dx = lo_x > query.x ? lo_x - query.x : (hi_x < query.x ? query.x - hi_x : 0.0);
+            double dy = lo_y > query.y ? lo_y - query.y : (hi_y < query.y ? query.y - hi_y : 0.0);
+            if (dx * dx + dy * dy < best[q].top().first) return true;
+        }
+        return false;
+    }
+    
+    // k vecinos más cercanos por cuadrante en un único recorrido: un heap
+    // acotado por cuadrante y poda con la caja del subárbol
+    void find_quadrant(size_t lo, size_t hi, int depth, const Point& query, size_t k, uint32_t exclude,
+                       const Box& box, std::priority_queue<std::pair<double, uint32_t>>* best) const {
+        if (lo >= hi || !box_needed(box, query, k, best)) return;
+        
+        nodes_visited++;
+        
+        if (is_leaf(lo, hi)) {
+            alignas(64) double dist_sq[max_leaf_size];
+            bucket_distances(lo, hi, query, dist_sq);
+            for (size_t i = 0; i < hi - lo; ++i) {
+                if (index_[lo + i] == exclude) continue;
+                int q = quadrant_of(xs_[lo + i] - query.x, ys_[lo + i] - query.y);
+                offer(best[q], k, dist_sq[i], index_[lo + i]);
             }
+            return;
+        }
+        
+        size_t mid = (lo + hi) / 2;
+        if (index_[mid] != exclude) {
+            int q = quadrant_of(xs_[mid] - query.x, ys_[mid] - query.y);
+            offer(best[q], k, distance_sq_to(mid, query), index_[mid]);
+        }
+        
+        bool axis = depth % 2 == 0;
+        double split = axis ? xs_[mid] : ys_[mid];
+        Box low = box, high = box;
+        if (axis) {
+            low.max_x = split;
+            high.min_x = split;
+        } else {
+            low.max_y = split;
+            high.min_y = split;
+        }
+        
+        // Primero el lado de la consulta: llena antes los heaps cercanos
+        if ((axis ? query.x : query.y) <= split) {
+            find_quadrant(lo, mid, depth + 1, query, k, exclude, low, best);
+            find_quadrant(mid + 1, hi, depth + 1, query, k, exclude, high, best);
+        } else {
+            find_quadrant(mid + 1, hi, depth + 1, query, k, exclude, high, best);
+            find_quadrant(lo, mid, depth + 1, query, k, exclude, low, best);
+        }
+    }
+    
+    // Suma delta a los contadores de los subárboles que contienen la posición pos
+    void update_alive_path(AliveSet& set, size_t pos, int delta) const {
+        size_t lo = 0, hi = size_;
+        while (true) {
+            if (is_leaf(lo, hi)) {
+                set.count[lo] += delta;
+                return;
+            }
+            size_t mid = (lo + hi) / 2;
+            set.count[mid] += delta;
+            if (pos == mid) return;
+            if (pos < mid) hi = mid; else lo = mid + 1;
         }
     }
 
 public:
-    KDTree() : size_(0), nodes_visited(0) {}
+    explicit KDTree(size_t leaf_size = default_leaf_size)
+        : leaf_size_(std::min(std::max<size_t>(leaf_size, 1), max_leaf_size)),
+          size_(0), min_x_(0), min_y_(0), max_x_(0), max_y_(0), nodes_visited(0) {}
     
-    void build(const std::vector<Point>& points) {
+    void build(const PointSet& points) {
         if (points.empty()) return;
         
-        std::vector<Point> points_copy = points;
-        root = build(points_copy, 0, 0, points.size());
-        size_ = points.size();
+        size_t n = points.size();
+        std::vector<uint32_t> order(n);
+        for (size_t i = 0; i < n; ++i) order[i] = static_cast<uint32_t>(i);
+        build(points, order, 0, n, 0);
+        
+        // Copiar las coordenadas en el orden del árbol (SoA contiguo por bucket)
+        xs_.resize(n);
+        ys_.resize(n);
+        for (size_t i = 0; i < n; ++i) {
+            xs_[i] = points.xs[order[i]];
+            ys_[i] = points.ys[order[i]];
+        }
+        index_ = std::move(order);
+        position_.resize(n);
+        for (size_t i = 0; i < n; ++i) position_[index_[i]] = static_cast<uint32_t>(i);
+        auto [min_x, max_x] = std::minmax_element(xs_.begin(), xs_.end());
+        auto [min_y, max_y] = std::minmax_element(ys_.begin(), ys_.end());
+        min_x_ = *min_x;
+        max_x_ = *max_x;
+        min_y_ = *min_y;
+        max_y_ = *max_y;
+        size_ = n;
         nodes_visited = 0;
     }
     
     // FRNN con radio fijo
-    std::vector<Point> find_neighbors(const Point& query, double radius) const {
-        std::vector<Point> neighbors;
+    std::vector<uint32_t> find_neighbors(const Point& query, double radius) const {
+        std::vector<uint32_t> neighbors;
         nodes_visited = 0;
-        find_neighbors_frnn(root.get(), query, radius, neighbors);
+        find_neighbors_frnn(0, index_.size(), 0, query, radius, neighbors);
         return neighbors;
     }
     
-    // Encuentra el vecino más cercano
-    Point find_nearest_neighbor(const Point& query) const {
-        if (!root) return Point();
+    // Encuentra el vecino más cercano (índice)
+    uint32_t find_nearest_neighbor(const Point& query) const {
+        if (index_.empty()) return 0;
+        
+        uint32_t best = index_[0];
+        double best_dist_sq = std::numeric_limits<double>::max();
+        nodes_visited = 0;
         
-        Point best = root->point;
-        double best_dist_sq = distance_squared(query, best);
+        find_nearest(0, index_.size(), 0, query, nullptr, best, best_dist_sq);
+        return best;
+    }
+    
+    // Vecino más cercano ignorando los puntos con excluded[i] == true.
+    // Devuelve size() si todos están excluidos.
+    uint32_t find_nearest_neighbor(const Point& query, const std::vector<bool>& excluded) const {
+        uint32_t best = static_cast<uint32_t>(size_);
+        double best_dist_sq = std::numeric_limits<double>::max();
         nodes_visited = 0;
         
-        find_nearest(root.get(), query, best, best_dist_sq);
+        find_nearest(0, index_.size(), 0, query, &excluded, best, best_dist_sq);
         return best;
     }
     
-    // Encuentra los k vecinos más cercanos
-    std::vector<Point> find_k_nearest_neighbors(const Point& query, size_t k) const {
-        std::priority_queue<std::pair<double, Point>> best_k;
+    // Estado con todos los puntos vivos (o ninguno, para conjuntos que crecen
+    // con revive, como las ciudades ya insertadas en un tour parcial)
+    AliveSet make_alive_set(bool alive = true) const {
+        AliveSet set;
+        reset_alive_set(set, alive);
+        return set;
+    }
+    
+    // Reinicia el conjunto reutilizando su memoria
+    void reset_alive_set(AliveSet& set, bool alive = true) const {
+        set.alive.assign(size_, alive ? 1 : 0);
+        set.count.assign(size_, 0);
+        set.remaining = alive ? size_ : 0;
+        set.nodes_visited = 0;
+        fill_alive_counts(0, size_, set, alive);
+    }
+    
+    // Borra un punto (índice del PointSet) del conjunto: O(log n), descontándolo
+    // de cada subárbol en el camino desde la raíz hasta su posición
+    void remove(AliveSet& set, uint32_t point) const {
+        size_t pos = position_[point];
+        if (!set.alive[pos]) return;
+        set.alive[pos] = 0;
+        set.remaining--;
+        update_alive_path(set, pos, -1);
+    }
+    
+    // Vuelve a agregar un punto al conjunto (inversa de remove)
+    void revive(AliveSet& set, uint32_t point) const {
+        size_t pos = position_[point];
+        if (set.alive[pos]) return;
+        set.alive[pos] = 1;
+        set.remaining++;
+        update_alive_path(set, pos, +1);
+    }
+    
+    // K vecinos vivos más cercanos, de más cercano a más lejano
+    std::vector<uint32_t> find_k_nearest_neighbors(const Point& query, size_t k, const AliveSet& set) const {
+        std::priority_queue<std::pair<double, uint32_t>> best_k;
+        if (k > 0) find_k_nearest_alive(0, size_, 0, query, k, set, best_k);
+        
+        std::vector<uint32_t> result(best_k.size());
+        for (size_t i = result.size(); i-- > 0; best_k.pop()) result[i] = best_k.top().second;
+        return result;
+    }
+    
+    // Vecino vivo más cercano (menor índice ante empates); size() si no quedan
+    uint32_t find_nearest_neighbor(const Point& query, const AliveSet& set) const {
+        uint32_t best = static_cast<uint32_t>(size_);
+        double best_dist_sq = std::numeric_limits<double>::max();
+        find_nearest_alive(0, size_, 0, query, set, best, best_dist_sq);
+        return best;
+    }
+    
+    // Encuentra los k vecinos más cercanos (índices)
+    std::vector<uint32_t> find_k_nearest_neighbors(const Point& query, size_t k) const {
+        std::priority_queue<std::pair<double, uint32_t>> best_k;
         nodes_visited = 0;
         
-        find_k_nearest(root.get(), query, k, best_k);
+        find_k_nearest(0, index_.size(), 0, query, k, best_k);
         
-        std::vector<Point> result;
+        std::vector<uint32_t> result;
         while (!best_k.empty()) {
             result.push_back(best_k.top().second);
             best_k.pop();
@@ -187,16 +535,39 @@ public:
         return result;
     }
     
+    // Vecinos balanceados por cuadrante: los k_per_quadrant más cercanos en
+    // cada uno de los cuatro cuadrantes alrededor de la consulta (menos si el
+    // cuadrante tiene menos puntos), juntos y de más cercano a más lejano.
+    // exclude omite un punto (normalmente la propia ciudad consultada).
+    std::vector<uint32_t> find_quadrant_neighbors(const Point& query, size_t k_per_quadrant,
+                                                  uint32_t exclude = std::numeric_limits<uint32_t>::max()) const {
+        std::priority_queue<std::pair<double, uint32_t>> best[4];
+        nodes_visited = 0;
+        if (k_per_quadrant > 0 && size_ > 0) {
+            Box box = {min_x_, min_y_, max_x_, max_y_};
+            find_quadrant(0, size_, 0, query, k_per_quadrant, exclude, box, best);
+        }
+        
+        std::vector<std::pair<double, uint32_t>> merged;
+        for (auto& heap : best) {
+            for (; !heap.empty(); heap.pop()) merged.push_back(heap.top());
+        }
+        std::sort(merged.begin(), merged.end());
+        std::vector<uint32_t> result(merged.size());
+        for (size_t i = 0; i < merged.size(); ++i) result[i] = merged[i].second;
+        return result;
+    }
+    
     // FRNN adaptativo: ajusta el radio según la densidad local
-    std::vector<Point> find_neighbors_adaptive(const Point& query, double base_radius, size_t min_neighbors = 5) const {
+    std::vector<uint32_t> find_neighbors_adaptive(const Point& query, double base_radius, size_t min_neighbors = 5) const {
         double radius = base_radius;
-        std::vector<Point> neighbors;
+        std::vector<uint32_t> neighbors;
         
         // Incrementar radio hasta encontrar suficientes vecinos
         while (neighbors.size() < min_neighbors && radius < 2.0) {
             neighbors.clear();
             nodes_visited = 0;
-            find_neighbors_frnn(root.get(), query, radius, neighbors);
+            find_neighbors_frnn(0, index_.size(), 0, query, radius, neighbors);
             if (neighbors.size() < min_neighbors) {
                 radius *= 1.5; // Incrementar radio
             }
@@ -206,6 +577,7 @@ public:
     }
     
     size_t size() const { return size_; }
+    size_t leaf_size() const { return leaf_size_; }
     size_t get_nodes_visited() const { return nodes_visited; }
     void reset_nodes_visited() const { nodes_visited = 0; }
-}; 
\ No newline at end of file
+};
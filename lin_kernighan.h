@@ -0,0 +1,223 @@
+#pragma once
+#include "point.h"
+#include "tour.h"
+#include "tour_utils.h"
+#include "candidates.h"
+#include "two_opt.h"
+#include <vector>
+#include <deque>
+#include <chrono>
+#include <iostream>
+#include <iomanip>
+#include <algorithm>
+
+// Parámetros de la búsqueda de profundidad variable
+struct LKConfig {
+    size_t max_depth;              // Movimientos 2-opt encadenados como máximo
+    std::vector<size_t> breadth;   // Alternativas t3 por nivel (los niveles siguientes usan 1)
+    double target_length;          // Detenerse al alcanzar esta longitud (0 = sin objetivo)
+    
+    LKConfig() : max_depth(10), breadth({5, 3, 1}), target_length(0) {}
+    
+    bool reached(double length) const { return target_length > 0 && length <= target_length; }
+    
+    size_t breadth_at(size_t level) const {
+        return level < breadth.size() ? breadth[level] : 1;
+    }
+};
+
+// =============== BÚSQUEDA LIN-KERNIGHAN (LK-STEP CON MOVIMIENTOS 2-OPT) ===============
+// Cada nivel rompe la arista de cierre (t1, t2), agrega (t2, t3) con t3 tomado de
+// los candidatos de t2 y rompe (t3, t4) para volver a cerrar el tour con (t4, t1):
+// es decir, un movimiento 2-opt secuencial. La cadena continúa desde (t1, t4)
+// mientras la ganancia parcial sea positiva; se conserva el mejor prefijo.
+// Las ciudades se procesan con una cola + don't-look bits como en dlb_2opt.
+// Plantilla sobre la representación del tour (Tour o TwoLevelTour).
+template <class TourT>
+class LinKernighan {
+private:
+    struct Move {
+        uint32_t a, b, c, d;   // make_2opt_move(a, b, c, d) aplicado
+        double d_ab, d_cd;     // Longitudes de las aristas eliminadas (para deshacer)
+        double d_ac, d_bd;     // Longitudes de las aristas agregadas
+    };
+    
+    struct Alternative {
+        uint32_t t3, t4;
+        double g1;             // Ganancia parcial tras agregar (t2, t3)
+        double d_t3t4;         // Longitud de la arista (t3, t4) a eliminar
+        double priority;
+    };
+    
+    static constexpr size_t max_alternatives = 64;
+    
+    const PointSet& points_;
+    TourT& tour_;
+    const CandidateLists& candidates_;
+    LKConfig config_;
+    OptimizationStats& stats_;
+    EdgeCache cache_;              // Longitudes de las aristas del tour actual
+    
+    std::vector<Move> moves_;      // Cadena aplicada en el intento actual
+    double best_gain_;
+    size_t best_length_;           // Prefijo de moves_ que logra best_gain_
+    
+    static constexpr double min_improvement = 1e-9;
+    
+    double dist(uint32_t a, uint32_t b) const { return distance(points_, a, b); }
+    
+    void apply(uint32_t a, uint32_t b, uint32_t c, uint32_t d) {
+        Move m = {a, b, c, d, cache_.length(a, b), cache_.length(c, d), dist(a, c), dist(b, d)};
+        make_2opt_move(tour_, a, b, c, d);
+        cache_.apply_2opt(a, b, c, d, m.d_ac, m.d_bd);
+        moves_.push_back(m);
+    }
+    
+    // Deshace el último movimiento: tras aplicarlo a -> c y b -> d son aristas
+    void undo_last() {
+        Move m = moves_.back();
+        moves_.pop_back();
+        make_2opt_move(tour_, m.a, m.c, m.b, m.d);
+        cache_.apply_2opt(m.a, m.c, m.b, m.d, m.d_ab, m.d_cd);
+    }
+    
+    // g: ganancia acumulada del tour actual respecto al original
+    bool step(size_t level, uint32_t t1, uint32_t t2, double g) {
+        bool forward = tour_.next(t1) == t2;
+        double g_open = g + cache_.length(t1, t2);   // Ganancia con (t1, t2) eliminada
+        
+        // Alternativas (t3, t4) válidas, ordenadas por d(t3,t4) - d(t2,t3) descendente
+        Alternative alternatives[max_alternatives];
+        size_t count = 0;
+        for (uint32_t t3 : candidates_.of(t2)) {
+            double d_t2t3 = dist(t2, t3);
+            double g1 = g_open - d_t2t3;
+            // Criterio de ganancia: candidatos ordenados, ninguno posterior sirve
+            if (g1 <= min_improvement) break;
+            
+            uint32_t t4 = forward ? tour_.prev(t3) : tour_.next(t3);
+            if (t3 == t1 || t4 == t2) continue;
+            
+            stats_.total_comparisons++;
+            double d_t3t4 = cache_.length(t3, t4);
+            alternatives[count++] = {t3, t4, g1, d_t3t4, d_t3t4 - d_t2t3};
+            if (count == max_alternatives) break;
+        }
+        std::sort(alternatives, alternatives + count,
+                  [](const Alternative& x, const Alternative& y) { return x.priority > y.priority; });
+        
+        size_t breadth = std::min(count, config_.breadth_at(level));
+        for (size_t alt = 0; alt < breadth; ++alt) {
+            uint32_t t3 = alternatives[alt].t3;
+            uint32_t t4 = alternatives[alt].t4;
+            double g1 = alternatives[alt].g1;
+            double d_t3t4 = alternatives[alt].d_t3t4;
+            
+            apply(t1, t2, t4, t3);
+            double closed = g1 + d_t3t4 - cache_.length(t4, t1);
+            if (closed > best_gain_) {
+                best_gain_ = closed;
+                best_length_ = moves_.size();
+            }
+            
+            if (level + 1 < config_.max_depth) {
+                step(level + 1, t1, t4, closed);
+            }
+            
+            if (best_gain_ > min_improvement) return true;
+            undo_last();
+        }
+        return false;
+    }
+
+public:
+    LinKernighan(const PointSet& points, TourT& tour, const CandidateLists& candidates,
+                 const LKConfig& config, OptimizationStats& stats)
+        : points_(points), tour_(tour), candidates_(candidates), config_(config),
+          stats_(stats), best_gain_(0), best_length_(0) {
+        cache_.build(points, tour);
+    }
+    
+    // Ganancia de la última cadena conservada por improve_from
+    double last_gain() const { return best_gain_; }
+    
+    // Intenta una cadena de mejora desde t1. Devuelve las ciudades tocadas por
+    // los movimientos conservados (vacío si no hubo mejora).
+    std::vector<uint32_t> improve_from(uint32_t t1) {
+        std::vector<uint32_t> touched;
+        
+        for (int dir = 0; dir < 2; ++dir) {
+            uint32_t t2 = dir == 0 ? tour_.next(t1) : tour_.prev(t1);
+            moves_.clear();
+            best_gain_ = min_improvement;
+            best_length_ = 0;
+            
+            if (step(0, t1, t2, 0.0)) {
+                // Conservar solo el mejor prefijo de la cadena
+                while (moves_.size() > best_length_) undo_last();
+                
+                for (const Move& m : moves_) {
+                    touched.insert(touched.end(), {m.a, m.b, m.c, m.d});
+                }
+                stats_.num_swaps += moves_.size();
+                return touched;
+            }
+        }
+        return touched;
+    }
+};
+
+template <class TourT>
+inline OptimizationStats lin_kernighan(const PointSet& points, TourT& tour,
+                                       const CandidateLists& candidates,
+                                       const LKConfig& config = LKConfig()) {
+    OptimizationStats stats;
+    stats.initial_length = tour_length(points, tour);
+    stats.num_visited = candidates.nodes_visited;
+    
+    auto start_time = std::chrono::high_resolution_clock::now();
+    size_t n = tour.size();
+    
+    std::vector<bool> in_queue(n, true);
+    auto sequence = tour_sequence(tour);
+    std::deque<uint32_t> queue(sequence.begin(), sequence.end());
+    stats.active_nodes = queue.size();
+    
+    LinKernighan<TourT> engine(points, tour, candidates, config, stats);
+    double length = stats.initial_length;
+    stats.target_reached = config.reached(length);
+    
+    while (n >= 8 && !queue.empty() && !stats.target_reached) {
+        uint32_t t1 = queue.front();
+        queue.pop_front();
+        in_queue[t1] = false;
+        stats.iterations++;
+        
+        std::vector<uint32_t> touched = engine.improve_from(t1);
+        if (!touched.empty()) length -= engine.last_gain();
+        for (uint32_t city : touched) {
+            if (!in_queue[city]) {
+                in_queue[city] = true;
+                queue.push_back(city);
+            }
+        }
+        stats.target_reached = config.reached(length);
+        
+        stats.active_nodes = std::max(stats.active_nodes, queue.size());
+        
+        if (stats.iterations % (100 * n) == 0) {
+            std::cout << "\rLin-Kernighan: Iter " << stats.iterations
+                      << ", Moves: " << stats.num_swaps
+                      << ", Queue: " << queue.size()
+                      << ", Length: " << std::fixed << std::setprecision(2)
+                      << tour_length(points, tour) << std::flush;
+        }
+    }
+    std::cout << std::endl;
+    
+    auto end_time = std::chrono::high_resolution_clock::now();
+    stats.cpu_time = std::chrono::duration<double>(end_time - start_time).count();
+    stats.final_length = tour_length(points, tour);
+    
+    return stats;
+}
@@ -1,11 +1,23 @@
 #include "point.h"
 #include "two_opt.h"
+#include "lin_kernighan.h"
+#include "two_level_tour.h"
+#include "grid_index.h"
+#include "construction.h"
+#include "delaunay.h"
+#include "one_tree.h"
 #include <iostream>
 #include <iomanip>
 #include <vector>
 #include <algorithm>
 #include <fstream>
-#include <numeric>
+#include <chrono>
+#include <string>
+#include <thread>
+#include <type_traits>
+#include <functional>
+#include <random>
+#include <limits>
 
 // Función para imprimir un separador elegante
 void print_separator(const std::string& title = "") {
@@ -17,43 +29,96 @@ void print_separator(const std::string& title = "") {
     }
 }
 
-// Función para mostrar información de la instancia
-void print_instance_info(const std::vector<Point>& points, const std::vector<Point>& tour) {
+// Hasta este tamaño la información de la instancia recorre todos los pares y
+// el benchmark completo incluye el 2-Opt básico (O(n²) por pasada)
+const size_t default_exact_limit = 10000;
+
+// Función para mostrar información de la instancia. Hasta exact_limit puntos
+// las distancias se acumulan sobre todos los pares sin guardarlos; por encima,
+// la mínima sale de las listas de candidatos (el vecino más cercano de cada
+// ciudad) y la máxima y el promedio de una muestra fija de pares.
+void print_instance_info(const PointSet& points, const Tour& tour, const CandidateLists& candidates,
+                         size_t exact_limit = default_exact_limit) {
     std::cout << "Información de la Instancia TSP:\n";
     std::cout << "- Número de puntos: " << points.size() << "\n";
-    std::cout << "- Longitud inicial (tour NN): " << std::fixed << std::setprecision(6) 
-              << tour_length(tour) << "\n";
+    std::cout << "- Longitud del tour inicial: " << std::fixed << std::setprecision(6) 
+              << tour_length(points, tour) << "\n";
+    
+    size_t n = points.size();
+    if (n < 2) return;
     
     // Calcular estadísticas de distancias
-    std::vector<double> distances;
-    for (size_t i = 0; i < points.size(); ++i) {
-        for (size_t j = i + 1; j < points.size(); ++j) {
-            distances.push_back(distance(points[i], points[j]));
+    double min_dist = std::numeric_limits<double>::max();
+    double max_dist = 0;
+    double sum_dist = 0;
+    size_t num_pairs = 0;
+    if (n <= exact_limit) {
+        for (size_t i = 0; i < n; ++i) {
+            for (size_t j = i + 1; j < n; ++j) {
+                double d = distance(points, i, j);
+                min_dist = std::min(min_dist, d);
+                max_dist = std::max(max_dist, d);
+                sum_dist += d;
+            }
+        }
+        num_pairs = n * (n - 1) / 2;
+    } else {
+        for (uint32_t i = 0; i < n; ++i) {
+            for (uint32_t j : candidates.of(i)) min_dist = std::min(min_dist, distance(points, i, j));
+        }
+        std::mt19937 gen(12345);
+        std::uniform_int_distribution<size_t> pick(0, n - 1);
+        num_pairs = 1000000;
+        for (size_t s = 0; s < num_pairs; ++s) {
+            size_t i = pick(gen), j = pick(gen);
+            while (j == i) j = pick(gen);
+            double d = distance(points, i, j);
+            max_dist = std::max(max_dist, d);
+            sum_dist += d;
         }
     }
-    
-    std::sort(distances.begin(), distances.end());
-    double min_dist = distances.front();
-    double max_dist = distances.back();
-    double avg_dist = std::accumulate(distances.begin(), distances.end(), 0.0) / distances.size();
+    double avg_dist = sum_dist / num_pairs;
     
     std::cout << "- Distancia mínima entre puntos: " << std::setprecision(4) << min_dist << "\n";
     std::cout << "- Distancia máxima entre puntos: " << max_dist << "\n";
-    std::cout << "- Distancia promedio entre puntos: " << avg_dist << "\n";
+    std::cout << "- Distancia promedio entre puntos: " << avg_dist;
+    if (n > exact_limit) std::cout << " (máxima y promedio sobre " << num_pairs << " pares al azar)";
+    std::cout << "\n";
+}
+
+// Extrae el valor de una opción "--nombre=valor"; false si arg no es esa opción
+bool parse_option(const std::string& arg, const std::string& name, std::string& value) {
+    std::string prefix = "--" + name + "=";
+    if (arg.compare(0, prefix.size(), prefix) != 0) return false;
+    value = arg.substr(prefix.size());
+    return true;
+}
+
+// Convierte una lista "5,3,1" en un vector de enteros
+std::vector<size_t> parse_size_list(const std::string& text) {
+    std::vector<size_t> values;
+    size_t start = 0;
+    while (start <= text.size()) {
+        size_t comma = text.find(',', start);
+        if (comma == std::string::npos) comma = text.size();
+        if (comma > start) values.push_back(std::stoul(text.substr(start, comma - start)));
+        start = comma + 1;
+    }
+    return values;
 }
 
 // Función para ejecutar y comparar todos los algoritmos
-void run_complete_benchmark(std::vector<Point>& points) {
+void run_complete_benchmark(const PointSet& points, const Tour& initial_tour,
+                            const CandidateLists& candidates, const LKConfig& lk_config,
+                            const TwoOptOptions& two_opt_options,
+                            const SegmentScheduleOptions& segment_options = SegmentScheduleOptions(),
+                            double lower_bound = 0, size_t exact_limit = default_exact_limit) {
     print_separator("OPTIMIZACIÓN TSP - ALGORITMOS 2-OPT");
     
-    // Crear tour inicial usando heurística Nearest Neighbor
-    std::cout << "Generando tour inicial con heurística Nearest Neighbor...\n";
-    auto initial_tour = best_nearest_neighbor_tour(points, 10); // Probar 10 puntos de inicio
-    
-    print_instance_info(points, initial_tour);
+    print_instance_info(points, initial_tour, candidates, exact_limit);
     
     // Verificar validez del tour inicial
-    if (!is_valid_tour(initial_tour, points)) {
+    if (!is_valid_tour(initial_tour, points.size())) {
         std::cerr << "ERROR: Tour inicial inválido!\n";
         return;
     }
@@ -65,29 +130,70 @@ void run_complete_benchmark(std::vector<Point>& points) {
     auto tour_geometric = initial_tour;
     auto tour_approximate = initial_tour;
     auto tour_hybrid = initial_tour;
+    auto tour_or_opt = initial_tour;
+    auto tour_segment = initial_tour;
+    auto tour_lk = initial_tour;
     
     // ================== EJECUTAR ALGORITMOS ==================
     
     print_separator("ALGORITMO 2-OPT BÁSICO");
-    std::cout << "Ejecutando 2-Opt Básico (búsqueda exhaustiva)...\n";
-    auto stats_basic = basic_2opt(tour_basic);
-    stats_basic.print_detailed_stats("Basic 2-Opt");
+    OptimizationStats stats_basic;
+    bool run_basic = points.size() <= exact_limit;
+    if (run_basic) {
+        std::cout << "Ejecutando 2-Opt Básico (búsqueda exhaustiva, kernel "
+                  << gain_kernel_name(detect_gain_kernel()) << ", " << two_opt_options.num_threads << " hilo(s)"
+                  << (two_opt_options.multi_move ? ", multi-movimiento" : "") << ")...\n";
+        stats_basic = basic_2opt(points, tour_basic, two_opt_options);
+        stats_basic.lower_bound = lower_bound;
+        stats_basic.print_detailed_stats("Basic 2-Opt");
+    } else {
+        std::cout << "Omitido: " << points.size() << " puntos > --exact-limit=" << exact_limit
+                  << " (búsqueda exhaustiva O(n²) por pasada)\n";
+    }
     
     print_separator("ALGORITMO 2-OPT GEOMÉTRICO");
     std::cout << "Ejecutando 2-Opt Geométrico (K-d Tree + FRNN)...\n";
-    auto stats_geometric = geometric_2opt(tour_geometric);
+    auto stats_geometric = geometric_2opt(points, tour_geometric, candidates, two_opt_options);
+    stats_geometric.lower_bound = lower_bound;
     stats_geometric.print_detailed_stats("Geometric 2-Opt");
     
     print_separator("ALGORITMO 2-OPT APROXIMADO");
-    std::cout << "Ejecutando 2-Opt Aproximado (bits de activación)...\n";
-    auto stats_approximate = approximate_2opt(tour_approximate);
+    std::cout << "Ejecutando 2-Opt Aproximado (don't-look bits + cola FIFO)...\n";
+    auto stats_approximate = approximate_2opt(points, tour_approximate, candidates, two_opt_options);
+    stats_approximate.lower_bound = lower_bound;
     stats_approximate.print_detailed_stats("Approximate 2-Opt");
     
     print_separator("ALGORITMO 2-OPT HÍBRIDO");
     std::cout << "Ejecutando 2-Opt Híbrido (K-d Tree + bits de activación)...\n";
-    auto stats_hybrid = hybrid_2opt(tour_hybrid);
+    auto stats_hybrid = hybrid_2opt(points, tour_hybrid, candidates, two_opt_options);
+    stats_hybrid.lower_bound = lower_bound;
     stats_hybrid.print_detailed_stats("Hybrid 2-Opt");
     
+    print_separator("2-OPT + OR-OPT");
+    std::cout << "Ejecutando 2-Opt (DLB) seguido de Or-Opt (segmentos de 1-3 ciudades)...\n";
+    auto stats_or_opt = dlb_2opt(points, tour_or_opt, candidates, two_opt_options);
+    stats_or_opt.merge(or_opt(points, tour_or_opt, candidates, two_opt_options));
+    stats_or_opt.lower_bound = lower_bound;
+    stats_or_opt.print_detailed_stats("2-Opt + Or-Opt");
+    
+    print_separator("2-OPT PLANIFICADO POR SEGMENTOS");
+    std::cout << "Ejecutando 2-Opt por ventanas de " << segment_options.segment_size
+              << " posiciones (peor ventana primero";
+    if (segment_options.score_ratio > 0) {
+        std::cout << ", hasta " << segment_options.score_ratio << "x la arista media";
+    }
+    std::cout << ")...\n";
+    auto stats_segment = segment_2opt(points, tour_segment, candidates, segment_options, two_opt_options);
+    stats_segment.lower_bound = lower_bound;
+    stats_segment.print_detailed_stats("Segment 2-Opt");
+    
+    print_separator("LIN-KERNIGHAN");
+    std::cout << "Ejecutando búsqueda LK de profundidad variable (profundidad máx. "
+              << lk_config.max_depth << ")...\n";
+    auto stats_lk = lin_kernighan(points, tour_lk, candidates, lk_config);
+    stats_lk.lower_bound = lower_bound;
+    stats_lk.print_detailed_stats("Lin-Kernighan");
+    
     // ================== ANÁLISIS COMPARATIVO ==================
     
     print_separator("ANÁLISIS COMPARATIVO");
@@ -99,10 +205,12 @@ void run_complete_benchmark(std::vector<Point>& points) {
               << std::setw(8) << "Swaps" 
               << std::setw(8) << "Time(s)" 
               << std::setw(12) << "Swaps/sec"
-              << std::setw(12) << "Comparisons" << "\n";
-    std::cout << std::string(85, '-') << "\n";
+              << std::setw(12) << "Comparisons";
+    if (lower_bound > 0) std::cout << std::setw(8) << "Gap";
+    std::cout << "\n";
+    std::cout << std::string(lower_bound > 0 ? 93 : 85, '-') << "\n";
     
-    auto print_row = [](const std::string& name, const OptimizationStats& stats) {
+    auto print_row = [lower_bound](const std::string& name, const OptimizationStats& stats) {
         double improvement = (stats.initial_length - stats.final_length) / stats.initial_length * 100.0;
         double swaps_per_sec = stats.cpu_time > 0 ? stats.num_swaps / stats.cpu_time : 0;
         
@@ -112,21 +220,31 @@ void run_complete_benchmark(std::vector<Point>& points) {
                   << std::setw(8) << stats.num_swaps
                   << std::setw(8) << std::setprecision(3) << stats.cpu_time
                   << std::setw(12) << std::setprecision(1) << swaps_per_sec
-                  << std::setw(12) << stats.total_comparisons << "\n";
+                  << std::setw(12) << stats.total_comparisons;
+        if (lower_bound > 0) {
+            std::cout << std::setprecision(2) << stats.gap() * 100.0 << "%" << (stats.target_reached ? " *" : "");
+        }
+        std::cout << "\n";
     };
     
-    print_row("Basic", stats_basic);
+    if (run_basic) print_row("Basic", stats_basic);
     print_row("Geometric", stats_geometric);
     print_row("Approximate", stats_approximate);
     print_row("Hybrid", stats_hybrid);
+    print_row("2-Opt+Or-Opt", stats_or_opt);
+    print_row("Segmented", stats_segment);
+    print_row("Lin-Kernighan", stats_lk);
     
     // Encontrar el mejor algoritmo
     std::vector<std::pair<std::string, OptimizationStats>> all_stats = {
-        {"Basic", stats_basic},
         {"Geometric", stats_geometric},
         {"Approximate", stats_approximate},
-        {"Hybrid", stats_hybrid}
+        {"Hybrid", stats_hybrid},
+        {"2-Opt+Or-Opt", stats_or_opt},
+        {"Segmented", stats_segment},
+        {"Lin-Kernighan", stats_lk}
     };
+    if (run_basic) all_stats.insert(all_stats.begin(), {"Basic", stats_basic});
     
     auto best = std::min_element(all_stats.begin(), all_stats.end(),
         [](const auto& a, const auto& b) {
@@ -135,6 +253,14 @@ void run_complete_benchmark(std::vector<Point>& points) {
     
     std::cout << "\n#best_algorithm: " << best->first 
               << " (Length: " << std::fixed << std::setprecision(6) << best->second.final_length << ")\n";
+    if (lower_bound > 0) {
+        std::cout << "#lower_bound: " << lower_bound << " (gap del mejor: " << std::setprecision(2)
+                  << (best->second.final_length - lower_bound) / lower_bound * 100.0 << "%)\n";
+        if (two_opt_options.target_length > 0) {
+            std::cout << "#target_length: " << std::setprecision(6) << two_opt_options.target_length
+                      << " (* = se detuvo al alcanzarla)\n";
+        }
+    }
     
     // Análisis de eficiencia
     print_separator("ANÁLISIS DE EFICIENCIA");
@@ -170,24 +296,290 @@ void run_complete_benchmark(std::vector<Point>& points) {
     }
 }
 
+// Benchmark de representaciones de tour: arreglo (Tour) vs lista de dos niveles
+// (TwoLevelTour) con los mismos drivers, para ubicar el punto de cruce
+void run_tour_representation_benchmark(const std::vector<size_t>& sizes, unsigned int seed,
+                                       bool use_clustered, size_t num_candidates,
+                                       const LKConfig& lk_config) {
+    print_separator("BENCHMARK DE REPRESENTACIÓN DEL TOUR");
+    
+    struct Row {
+        size_t n;
+        double dlb_array, dlb_two_level;
+        double lk_array, lk_two_level;
+    };
+    std::vector<Row> rows;
+    
+    for (size_t n : sizes) {
+        PointSet points = use_clustered ? generate_clustered_points(n, 5, seed)
+                                        : generate_random_points(n, seed);
+        CandidateLists candidates;
+        candidates.build(points, num_candidates);
+        Tour initial_tour = nearest_neighbor_tour(points, 0);
+        
+        Row row;
+        row.n = n;
+        
+        Tour dlb_array = initial_tour;
+        row.dlb_array = dlb_2opt(points, dlb_array, candidates).cpu_time;
+        TwoLevelTour dlb_two_level(initial_tour);
+        row.dlb_two_level = dlb_2opt(points, dlb_two_level, candidates).cpu_time;
+        
+        Tour lk_array = initial_tour;
+        row.lk_array = lin_kernighan(points, lk_array, candidates, lk_config).cpu_time;
+        TwoLevelTour lk_two_level(initial_tour);
+        row.lk_two_level = lin_kernighan(points, lk_two_level, candidates, lk_config).cpu_time;
+        
+        rows.push_back(row);
+    }
+    
+    std::cout << "#tour_representation Table of Results:\n";
+    std::cout << std::left << std::setw(10) << "Points"
+              << std::setw(14) << "DLB Array(s)"
+              << std::setw(14) << "DLB 2-Lvl(s)"
+              << std::setw(14) << "LK Array(s)"
+              << std::setw(14) << "LK 2-Lvl(s)"
+              << std::setw(12) << "LK Speedup" << "\n";
+    std::cout << std::string(78, '-') << "\n";
+    
+    size_t crossover = 0;
+    for (const Row& row : rows) {
+        double speedup = row.lk_two_level > 0 ? row.lk_array / row.lk_two_level : 0;
+        std::cout << std::left << std::setw(10) << row.n
+                  << std::setw(14) << std::fixed << std::setprecision(4) << row.dlb_array
+                  << std::setw(14) << row.dlb_two_level
+                  << std::setw(14) << row.lk_array
+                  << std::setw(14) << row.lk_two_level
+                  << std::setw(12) << std::setprecision(2) << speedup << "\n";
+        if (crossover == 0 && row.lk_two_level < row.lk_array) crossover = row.n;
+    }
+    
+    if (crossover > 0) {
+        std::cout << "#two_level_crossover: " << crossover << " points\n";
+    } else {
+        std::cout << "#two_level_crossover: not reached\n";
+    }
+}
+
+// Tiempos de un índice espacial en las consultas que usan los algoritmos
+struct IndexTimings {
+    double build, knn, frnn, nn_tour;
+    
+    double total() const { return build + knn + frnn + nn_tour; }
+};
+
+template <class Index>
+IndexTimings time_spatial_index(const PointSet& points, Index& index, size_t num_candidates) {
+    using clock = std::chrono::high_resolution_clock;
+    auto seconds = [](clock::time_point a, clock::time_point b) {
+        return std::chrono::duration<double>(b - a).count();
+    };
+    IndexTimings t;
+    
+    auto t0 = clock::now();
+    index.build(points);
+    auto t1 = clock::now();
+    CandidateLists candidates;
+    candidates.build(points, index, num_candidates);
+    auto t2 = clock::now();
+    
+    // FRNN con radio de ~2 distancias medias al vecino más cercano
+    double radius = 1.0 / std::sqrt(static_cast<double>(points.size()));
+    size_t found = 0;
+    for (size_t i = 0; i < points.size(); ++i) {
+        found += index.find_neighbors(points[i], radius).size();
+    }
+    auto t3 = clock::now();
+    Tour tour = spatial_nearest_neighbor_tour(points, index, 0);
+    auto t4 = clock::now();
+    
+    if (found == 0 || !is_valid_tour(tour, points.size())) {
+        std::cerr << "ERROR: resultado inválido en el benchmark de índices\n";
+    }
+    t.build = seconds(t0, t1);
+    t.knn = seconds(t1, t2);
+    t.frnn = seconds(t2, t3);
+    t.nn_tour = seconds(t3, t4);
+    return t;
+}
+
+// Benchmark de índices espaciales: KDTree vs GridIndex sobre instancias
+// aleatorias y agrupadas (construcción, K-NN, FRNN y tour NN)
+void run_index_benchmark(const std::vector<size_t>& sizes, unsigned int seed,
+                         size_t num_candidates, size_t leaf_size) {
+    print_separator("BENCHMARK DE ÍNDICES ESPACIALES");
+    
+    std::cout << "#spatial_index Table of Results:\n";
+    std::cout << std::left << std::setw(10) << "Points"
+              << std::setw(11) << "Instance"
+              << std::setw(9) << "Index"
+              << std::setw(11) << "Build(s)"
+              << std::setw(11) << "K-NN(s)"
+              << std::setw(11) << "FRNN(s)"
+              << std::setw(11) << "NN Tour(s)"
+              << std::setw(10) << "Total(s)" << "\n";
+    std::cout << std::string(84, '-') << "\n";
+    
+    auto print_row = [](size_t n, const std::string& instance, const std::string& index,
+                        const IndexTimings& t) {
+        std::cout << std::left << std::setw(10) << n
+                  << std::setw(11) << instance
+                  << std::setw(9) << index
+                  << std::setw(11) << std::fixed << std::setprecision(4) << t.build
+                  << std::setw(11) << t.knn
+                  << std::setw(11) << t.frnn
+                  << std::setw(11) << t.nn_tour
+                  << std::setw(10) << t.total() << "\n";
+    };
+    
+    std::vector<std::string> winners;
+    for (size_t n : sizes) {
+        for (bool clustered : {false, true}) {
+            PointSet points = clustered ? generate_clustered_points(n, 5, seed)
+                                        : generate_random_points(n, seed);
+            std::string instance = clustered ? "clustered" : "random";
+            
+            KDTree tree(leaf_size);
+            IndexTimings kd = time_spatial_index(points, tree, num_candidates);
+            GridIndex grid;
+            IndexTimings gr = time_spatial_index(points, grid, num_candidates);
+            
+            print_row(n, instance, "KDTree", kd);
+            print_row(n, instance, "Grid", gr);
+            winners.push_back(std::to_string(n) + " " + instance + ": " +
+                              (gr.total() < kd.total() ? "Grid" : "KDTree"));
+        }
+    }
+    
+    for (const std::string& winner : winners) {
+        std::cout << "#index_winner " << winner << "\n";
+    }
+}
+
+// Benchmark de construcciones del tour inicial sobre instancias aleatorias y
+// agrupadas: tiempo y longitud de cada constructor, relativa al NN
+void run_construction_benchmark(const std::vector<size_t>& sizes, unsigned int seed,
+                                size_t num_candidates, size_t leaf_size) {
+    print_separator("BENCHMARK DE CONSTRUCCIONES");
+    
+    std::cout << "#construction Table of Results:\n";
+    std::cout << std::left << std::setw(10) << "Points"
+              << std::setw(11) << "Instance"
+              << std::setw(10) << "Builder"
+              << std::setw(11) << "Time(s)"
+              << std::setw(14) << "Length"
+              << std::setw(10) << "vs NN" << "\n";
+    std::cout << std::string(66, '-') << "\n";
+    
+    using clock = std::chrono::high_resolution_clock;
+    for (size_t n : sizes) {
+        for (bool clustered : {false, true}) {
+            PointSet points = clustered ? generate_clustered_points(n, 5, seed)
+                                        : generate_random_points(n, seed);
+            std::string instance = clustered ? "clustered" : "random";
+            KDTree tree(leaf_size);
+            tree.build(points);
+            CandidateLists candidates;
+            candidates.build(points, tree, num_candidates);
+            
+            struct Builder {
+                const char* name;
+                std::function<Tour()> build;
+            };
+            const std::vector<Builder> builders = {
+                {"nn", [&] { return spatial_nearest_neighbor_tour(points, tree, 0); }},
+                {"greedy", [&] { return greedy_edge_tour(points, tree, candidates); }},
+                {"savings", [&] { return savings_tour(points, tree, candidates); }},
+                {"farthest", [&] { return farthest_insertion_tour(points, tree); }},
+                {"cheapest", [&] { return cheapest_insertion_tour(points, tree, candidates); }},
+                {"hilbert", [&] { return hilbert_curve_tour(points); }},
+            };
+            
+            double nn_length = 0;
+            for (const Builder& builder : builders) {
+                auto start = clock::now();
+                Tour tour = builder.build();
+                double seconds = std::chrono::duration<double>(clock::now() - start).count();
+                if (!is_valid_tour(tour, n)) {
+                    std::cerr << "ERROR: tour inválido de " << builder.name << "\n";
+                    continue;
+                }
+                double length = tour_length(points, tour);
+                if (nn_length == 0) nn_length = length;
+                std::cout << std::left << std::setw(10) << n
+                          << std::setw(11) << instance
+                          << std::setw(10) << builder.name
+                          << std::setw(11) << std::fixed << std::setprecision(4) << seconds
+                          << std::setw(14) << length
+                          << std::showpos << std::setprecision(2) << 100.0 * (length / nn_length - 1.0)
+                          << std::noshowpos << "%\n";
+            }
+        }
+    }
+}
+
 // Función para guardar resultados en archivo
-void save_results_to_file(const std::vector<Point>& points, const std::vector<Point>& best_tour, 
-                         const std::string& filename = "tsp_results.txt") {
+// original_ids (opcional): identificador de entrada de cada punto si se renumeraron
+void save_results_to_file(const PointSet& points, const Tour& best_tour, 
+                         const std::string& filename = "tsp_results.txt",
+                         const std::vector<uint32_t>& original_ids = {}) {
     std::ofstream file(filename);
     if (file.is_open()) {
         file << "TSP Optimization Results\n";
         file << "Points: " << points.size() << "\n";
-        file << "Best Tour Length: " << std::fixed << std::setprecision(6) << tour_length(best_tour) << "\n";
+        file << "Best Tour Length: " << std::fixed << std::setprecision(6) << tour_length(points, best_tour) << "\n";
         file << "\nBest Tour Sequence:\n";
         for (size_t i = 0; i < best_tour.size(); ++i) {
-            file << i << ": (" << std::setprecision(6) << best_tour[i].x 
-                 << ", " << best_tour[i].y << ") ID:" << best_tour[i].id << "\n";
+            uint32_t city = best_tour[i];
+            file << i << ": (" << std::setprecision(6) << points.xs[city] 
+                 << ", " << points.ys[city] << ") ID:"
+                 << (original_ids.empty() ? city : original_ids[city]) << "\n";
         }
         file.close();
         std::cout << "\nResultados guardados en: " << filename << "\n";
     }
 }
 
+// Con --candidates=quadrant, --k se reparte entre los cuatro cuadrantes
+size_t quadrant_candidates(size_t num_candidates) {
+    return std::max<size_t>(1, (num_candidates + 3) / 4);
+}
+
+// Tour inicial según --init sobre el K-d tree: NN multi-inicio (paralelo con
+// --threads y con presupuesto opcional), Greedy Edge o ahorros (Clarke-Wright)
+// sobre los candidatos, inserción más lejana / más barata o curva de Hilbert
+Tour build_initial_tour(const PointSet& points, const KDTree& tree, const CandidateLists& candidates,
+                        const std::string& method, const MultiStartOptions& nn_options) {
+    auto start = std::chrono::high_resolution_clock::now();
+    Tour tour;
+    if (method == "greedy") {
+        std::cout << "Generando tour inicial con Greedy Edge (listas de candidatos)...\n";
+        tour = greedy_edge_tour(points, tree, candidates);
+    } else if (method == "savings") {
+        std::cout << "Generando tour inicial con ahorros de Clarke-Wright (listas de candidatos)...\n";
+        tour = savings_tour(points, tree, candidates);
+    } else if (method == "farthest") {
+        std::cout << "Generando tour inicial con inserción más lejana...\n";
+        tour = farthest_insertion_tour(points, tree);
+    } else if (method == "cheapest") {
+        std::cout << "Generando tour inicial con inserción más barata...\n";
+        tour = cheapest_insertion_tour(points, tree, candidates);
+    } else if (method == "hilbert") {
+        std::cout << "Generando tour inicial con la curva de Hilbert...\n";
+        tour = hilbert_curve_tour(points);
+    } else {
+        std::cout << "Generando tour inicial con heurística Nearest Neighbor...\n";
+        MultiStartStats nn_stats;
+        tour = parallel_best_nearest_neighbor_tour(points, tree, nn_options, &nn_stats);
+        std::cout << "Tour NN: " << nn_stats.starts_done << " inicios, mejor inicio "
+                  << nn_stats.best_start << "\n";
+    }
+    auto end = std::chrono::high_resolution_clock::now();
+    std::cout << "Tour inicial construido en " << std::fixed << std::setprecision(4)
+              << std::chrono::duration<double>(end - start).count() << "s\n";
+    return tour;
+}
+
 int main(int argc, char* argv[]) {
     std::cout << "=== OPTIMIZACIÓN TSP CON ALGORITMOS 2-OPT ===\n";
     std::cout << "Implementación fiel del paper de optimizaciones geométricas\n";
@@ -196,19 +588,175 @@ int main(int argc, char* argv[]) {
     size_t n_points = 100;
     unsigned int seed = 42;
     bool use_clustered = false;
+    size_t num_candidates = 10;     // K vecinos candidatos por ciudad
+    size_t leaf_size = KDTree::default_leaf_size;   // Puntos por bucket del K-d tree
+    bool use_grid = false;          // Índice espacial: K-d tree (defecto) o grilla uniforme
+    TwoOptOptions two_opt_options;  // Hilos (0 = todos los núcleos) y modo multi-movimiento
+    MultiStartOptions nn_options;   // Inicios del tour NN inicial (hilos = --threads)
+    bool nn_starts_given = false;
+    std::string init_method = "nn"; // Construcción del tour inicial (--init)
+    std::string candidate_method = "knn";   // Listas de candidatos (--candidates)
+    OneTreeOptions one_tree_options;        // Candidatos alfa: ascenso de π y límite exacto
+    SegmentScheduleOptions segment_options; // Ventanas del 2-Opt por segmentos
+    size_t exact_limit = default_exact_limit;   // Tope de n para el 2-Opt básico y las distancias exactas
+    bool compute_bound = false;     // Calcular la cota de Held-Karp y reportar gaps
+    size_t bound_iterations = 100;  // Iteraciones de subgradiente de la cota
+    double target_gap = 0;          // Gap objetivo (fracción): los solvers paran al alcanzarlo
+    bool hilbert_renumbering = false;   // Renumerar los puntos en orden de Hilbert
+    LKConfig lk_config;
+    std::vector<size_t> bench_tour_sizes;   // Vacío: no ejecutar el benchmark de tours
+    std::vector<size_t> bench_index_sizes;  // Vacío: no ejecutar el benchmark de índices
+    std::vector<size_t> bench_init_sizes;   // Vacío: no ejecutar el benchmark de construcciones
+    
+    // Procesar argumentos de línea de comandos: posicionales y opciones --nombre=valor
+    std::vector<std::string> positional;
+    for (int a = 1; a < argc; ++a) {
+        std::string arg = argv[a];
+        std::string value;
+        if (parse_option(arg, "k", value)) {
+            num_candidates = std::stoul(value);
+        } else if (parse_option(arg, "threads", value)) {
+            two_opt_options.num_threads = std::stoul(value);
+            if (two_opt_options.num_threads == 0) {
+                two_opt_options.num_threads = std::max(1u, std::thread::hardware_concurrency());
+            }
+        } else if (parse_option(arg, "init", value)) {
+            const std::vector<std::string> methods = {"nn", "greedy", "savings", "farthest", "cheapest", "hilbert"};
+            if (std::find(methods.begin(), methods.end(), value) == methods.end()) {
+                std::cerr << "Construcción desconocida: " << value
+                          << " (nn|greedy|savings|farthest|cheapest|hilbert)\n";
+                return 1;
+            }
+            init_method = value;
+        } else if (parse_option(arg, "candidates", value)) {
+            if (value != "knn" && value != "delaunay" && value != "quadrant" && value != "alpha") {
+                std::cerr << "Candidatos desconocidos: " << value << " (knn|delaunay|quadrant|alpha)\n";
+                return 1;
+            }
+            candidate_method = value;
+        } else if (parse_option(arg, "alpha-ascent", value)) {
+            one_tree_options.ascent_iterations = std::stoul(value);
+        } else if (parse_option(arg, "alpha-exact", value)) {
+            one_tree_options.exact_limit = std::stoul(value);
+        } else if (arg == "--hk-bound") {
+            compute_bound = true;
+        } else if (parse_option(arg, "hk-bound", value)) {
+            compute_bound = true;
+            bound_iterations = std::stoul(value);
+        } else if (parse_option(arg, "target-gap", value)) {
+            target_gap = std::stod(value) / 100.0;
+            compute_bound = true;
+        } else if (parse_option(arg, "exact-limit", value)) {
+            exact_limit = std::stoul(value);
+        } else if (parse_option(arg, "segment-size", value)) {
+            segment_options.segment_size = std::stoul(value);
+        } else if (parse_option(arg, "segment-threshold", value)) {
+            segment_options.score_ratio = std::stod(value);
+        } else if (parse_option(arg, "nn-starts", value)) {
+            nn_options.num_starts = std::stoul(value);
+            nn_starts_given = true;
+        } else if (parse_option(arg, "nn-budget", value)) {
+            nn_options.time_budget = std::stod(value) / 1000.0;
+        } else if (arg == "--hilbert-renumber") {
+            hilbert_renumbering = true;
+        } else if (arg == "--multi-move") {
+            two_opt_options.multi_move = true;
+        } else if (parse_option(arg, "leaf-size", value)) {
+            leaf_size = std::stoul(value);
+        } else if (parse_option(arg, "index", value)) {
+            if (value != "kdtree" && value != "grid") {
+                std::cerr << "Índice desconocido: " << value << " (kdtree|grid)\n";
+                return 1;
+            }
+            use_grid = value == "grid";
+        } else if (parse_option(arg, "lk-depth", value)) {
+            lk_config.max_depth = std::stoul(value);
+        } else if (parse_option(arg, "lk-breadth", value)) {
+            lk_config.breadth = parse_size_list(value);
+        } else if (arg == "--bench-tours") {
+            bench_tour_sizes = {1000, 2000, 5000, 10000, 20000};
+        } else if (parse_option(arg, "bench-tours", value)) {
+            bench_tour_sizes = parse_size_list(value);
+        } else if (arg == "--bench-init") {
+            bench_init_sizes = {10000, 100000};
+        } else if (parse_option(arg, "bench-init", value)) {
+            bench_init_sizes = parse_size_list(value);
+        } else if (arg == "--bench-index") {
+            bench_index_sizes = {10000, 50000, 200000};
+        } else if (parse_option(arg, "bench-index", value)) {
+            bench_index_sizes = parse_size_list(value);
+        } else if (arg.compare(0, 2, "--") == 0) {
+            std::cerr << "Opción desconocida: " << arg << "\n";
+            return 1;
+        } else {
+            positional.push_back(arg);
+        }
+    }
+    if (positional.size() > 0) n_points = std::stoul(positional[0]);
+    if (positional.size() > 1) seed = std::stoul(positional[1]);
+    if (positional.size() > 2) use_clustered = (positional[2] == "clustered");
+    
+    // Por encima de --exact-limit la cota de Held-Karp no está garantizada
+    if (target_gap > 0 && n_points > exact_limit) {
+        std::cerr << "--target-gap requiere n <= --exact-limit (" << exact_limit
+                  << "): por encima la cota de Held-Karp es solo una estimación\n";
+        return 1;
+    }
+    
+    // Con presupuesto de tiempo y sin --nn-starts: tantos inicios como quepan
+    nn_options.num_threads = two_opt_options.num_threads;
+    if (nn_options.time_budget > 0 && !nn_starts_given) nn_options.num_starts = n_points;
     
-    // Procesar argumentos de línea de comandos
-    if (argc > 1) n_points = std::stoul(argv[1]);
-    if (argc > 2) seed = std::stoul(argv[2]);
-    if (argc > 3) use_clustered = (std::string(argv[3]) == "clustered");
+    if (!bench_tour_sizes.empty()) {
+        run_tour_representation_benchmark(bench_tour_sizes, seed, use_clustered,
+                                          num_candidates, lk_config);
+        return 0;
+    }
+    if (!bench_index_sizes.empty()) {
+        run_index_benchmark(bench_index_sizes, seed, num_candidates, leaf_size);
+        return 0;
+    }
+    if (!bench_init_sizes.empty()) {
+        run_construction_benchmark(bench_init_sizes, seed, num_candidates, leaf_size);
+        return 0;
+    }
     
     std::cout << "Configuración:\n";
     std::cout << "- Número de puntos: " << n_points << "\n";
     std::cout << "- Semilla aleatoria: " << seed << "\n";
     std::cout << "- Tipo de instancia: " << (use_clustered ? "Clustered" : "Random") << "\n";
+    if (candidate_method == "delaunay") {
+        std::cout << "- Candidatos: grafo de Delaunay\n";
+    } else if (candidate_method == "quadrant") {
+        std::cout << "- Candidatos por cuadrante: " << quadrant_candidates(num_candidates) << "\n";
+    } else if (candidate_method == "alpha") {
+        std::cout << "- Candidatos alfa por ciudad (K): " << num_candidates
+                  << " (ascenso " << one_tree_options.ascent_iterations << " iteraciones)\n";
+    } else {
+        std::cout << "- Candidatos por ciudad (K): " << num_candidates << "\n";
+    }
+    std::cout << "- Hilos (2-Opt básico): " << two_opt_options.num_threads << "\n";
+    std::cout << "- 2-Opt básico y distancias exactas hasta: " << exact_limit << " puntos\n";
+    std::cout << "- Tour inicial: " << init_method << "\n";
+    std::cout << "- Renumeración de Hilbert: " << (hilbert_renumbering ? "Sí" : "No") << "\n";
+    std::cout << "- Inicios del tour NN: " << nn_options.num_starts;
+    if (nn_options.time_budget > 0) std::cout << " (presupuesto " << nn_options.time_budget * 1000 << " ms)";
+    std::cout << "\n";
+    std::cout << "- Multi-movimiento (2-Opt básico/geométrico/híbrido): "
+              << (two_opt_options.multi_move ? "Sí" : "No") << "\n";
+    std::cout << "- Ventanas del 2-Opt por segmentos: " << segment_options.segment_size << " posiciones";
+    if (segment_options.score_ratio > 0) std::cout << ", umbral " << segment_options.score_ratio << "x la arista media";
+    std::cout << "\n";
+    std::cout << "- Índice espacial: " << (use_grid ? "Grilla uniforme" : "K-d tree") << "\n";
+    if (compute_bound) {
+        std::cout << "- Cota de Held-Karp: " << bound_iterations << " iteraciones";
+        if (target_gap > 0) std::cout << ", gap objetivo " << target_gap * 100.0 << "%";
+        std::cout << "\n";
+    }
+    if (!use_grid) std::cout << "- Tamaño de bucket del K-d tree: " << leaf_size << "\n";
     
     // Generar instancia del problema
-    std::vector<Point> points;
+    PointSet points;
     if (use_clustered) {
         points = generate_clustered_points(n_points, 5, seed);
         std::cout << "Generando instancia con puntos agrupados...\n";
@@ -222,14 +770,100 @@ int main(int argc, char* argv[]) {
         return 1;
     }
     
+    // Renumerar antes de construir índices y candidatos (localidad de memoria)
+    std::vector<uint32_t> original_ids;
+    if (hilbert_renumbering) original_ids = hilbert_renumber(points);
+    
+    // Listas de candidatos (una sola vez por instancia) y tour inicial, ambos
+    // sobre el índice espacial elegido; con --candidates=delaunay las listas
+    // son los vecinos de la triangulación, con --candidates=quadrant los más
+    // cercanos de cada cuadrante (siempre sobre el K-d tree) y con
+    // --candidates=alpha los K de menor alfa según el 1-árbol mínimo
+    CandidateLists candidates;
+    Tour initial_tour;
+    auto build_with_index = [&](const auto& index) {
+        auto cand_start = std::chrono::high_resolution_clock::now();
+        if (candidate_method == "delaunay") {
+            DelaunayTriangulation triangulation;
+            triangulation.build(points);
+            triangulation.to_candidates(points, candidates);
+            std::cout << "Triangulación de Delaunay: " << triangulation.num_edges() << " aristas\n";
+        } else if (candidate_method == "alpha") {
+            one_tree_options.num_candidates = num_candidates;
+            OneTree one_tree;
+            one_tree.build(points, one_tree_options);
+            one_tree.to_candidates(points, candidates, num_candidates);
+            std::cout << "Cota del 1-árbol: " << std::fixed << std::setprecision(4) << one_tree.lower_bound()
+                      << " (" << one_tree.ascent_iterations_done() << " iteraciones de ascenso)\n";
+        } else if (candidate_method == "quadrant") {
+            if constexpr (std::is_same<std::decay_t<decltype(index)>, KDTree>::value) {
+                candidates.build_quadrant(points, index, quadrant_candidates(num_candidates));
+            } else {
+                KDTree tree(leaf_size);
+                tree.build(points);
+                candidates.build_quadrant(points, tree, quadrant_candidates(num_candidates));
+            }
+        } else {
+            candidates.build(points, index, num_candidates);
+        }
+        auto cand_end = std::chrono::high_resolution_clock::now();
+        std::cout << "Listas de candidatos construidas en " << std::fixed << std::setprecision(4)
+                  << std::chrono::duration<double>(cand_end - cand_start).count() << "s\n";
+        
+        if constexpr (std::is_same<std::decay_t<decltype(index)>, KDTree>::value) {
+            initial_tour = build_initial_tour(points, index, candidates, init_method, nn_options);
+        } else if (init_method == "nn") {
+            std::cout << "Generando tour inicial con heurística Nearest Neighbor...\n";
+            initial_tour = best_spatial_nearest_neighbor_tour(points, index, nn_options.num_starts);
+        } else {
+            // Las demás construcciones necesitan el K-d tree
+            KDTree tree(leaf_size);
+            tree.build(points);
+            initial_tour = build_initial_tour(points, tree, candidates, init_method, nn_options);
+        }
+    };
+    if (use_grid) {
+        GridIndex grid;
+        grid.build(points);
+        build_with_index(grid);
+    } else {
+        KDTree tree(leaf_size);
+        tree.build(points);
+        build_with_index(tree);
+    }
+    
+    // Cota inferior de Held-Karp: gap de cada solver y longitud objetivo
+    double lower_bound = 0;
+    if (compute_bound) {
+        auto bound_start = std::chrono::high_resolution_clock::now();
+        HeldKarpBound bound = held_karp_bound(points, bound_iterations, exact_limit);
+        auto bound_end = std::chrono::high_resolution_clock::now();
+        std::cout << (bound.exact ? "Cota de Held-Karp: " : "Estimación de Held-Karp (Delaunay, no garantizada): ")
+                  << std::fixed << std::setprecision(6) << bound.value
+                  << " (gap del tour inicial " << std::setprecision(2)
+                  << (tour_length(points, initial_tour) - bound.value) / bound.value * 100.0 << "%), "
+                  << std::setprecision(4) << std::chrono::duration<double>(bound_end - bound_start).count() << "s\n";
+        
+        // Solo una cota garantizada alimenta la columna Gap y el objetivo
+        if (bound.exact) {
+            lower_bound = bound.value;
+        } else {
+            std::cout << "Sin columna Gap: n > --exact-limit=" << exact_limit << "\n";
+        }
+        if (target_gap > 0 && lower_bound > 0) {
+            two_opt_options.target_length = lower_bound * (1.0 + target_gap);
+            lk_config.target_length = two_opt_options.target_length;
+        }
+    }
+    
     // Ejecutar benchmark completo
     try {
-        run_complete_benchmark(points);
+        run_complete_benchmark(points, initial_tour, candidates, lk_config, two_opt_options, segment_options, lower_bound, exact_limit);
         
         // Guardar el mejor resultado (usando geometric por defecto)
-        auto best_tour = best_nearest_neighbor_tour(points);
-        geometric_2opt(best_tour);
-        save_results_to_file(points, best_tour);
+        Tour best_tour = initial_tour;
+        geometric_2opt(points, best_tour, candidates, two_opt_options);
+        save_results_to_file(points, best_tour, "tsp_results.txt", original_ids);
         
     } catch (const std::exception& e) {
         std::cerr << "Error durante la optimización: " << e.what() << "\n";
@@ -239,7 +873,7 @@ int main(int argc, char* argv[]) {
     print_separator();
     std::cout << "Optimización completada exitosamente.\n";
     std::cout << "Para ejecutar con diferentes parámetros:\n";
-    std::cout << "./tsp_optimization [num_points] [seed] [random|clustered]\n";
+    std::cout << "./tsp_optimization [num_points] [seed] [random|clustered] [--opciones]\n";
     std::cout << "Ejemplo: ./tsp_optimization 200 123 clustered\n";
     
     return 0;
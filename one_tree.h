@@ -0,0 +1,427 @@
+#pragma once
+#include "point.h"
+#include "candidates.h"
+#include "delaunay.h"
+#include <vector>
+#include <queue>
+#include <cstdint>
+#include <limits>
+#include <algorithm>
+#include <cmath>
+#include <tuple>
+#include <functional>
+
+// =============== CANDIDATOS ALFA (1-ÁRBOLES) ===============
+// Un 1-árbol mínimo es un árbol generador mínimo más una arista extra en una
+// de sus hojas (la segunda más corta de esa hoja). Todo tour es un 1-árbol, así
+// que su longitud es una cota inferior. alfa(i, j) es cuánto crece el 1-árbol
+// mínimo si se le obliga a contener la arista (i, j): c(i, j) menos la arista
+// más larga del camino del árbol entre i y j. Las aristas del tour óptimo
+// tienen alfa pequeño mucho más a menudo que distancia pequeña, por eso los K
+// candidatos de menor alfa rinden más que los K más cercanos (Helsgaun, LKH).
+// Los costos son c(i, j) = d(i, j) + π_i + π_j. El ascenso por subgradiente
+// (opcional) ajusta π para que el 1-árbol se parezca a un tour: sube la cota
+// w(π) = L(T_π) - 2 Σ π y afina los alfa.
+// Hasta exact_limit ciudades el árbol es exacto (Prim denso O(n²)) y alfa se
+// calcula para todos los pares en O(n²) tiempo y O(n) memoria. Por encima, el
+// árbol se construye sobre las aristas de Delaunay y alfa se evalúa solo para
+// los vecinos de Delaunay a uno y dos saltos.
+struct OneTreeOptions {
+    size_t num_candidates;       // K candidatos alfa por ciudad
+    size_t ascent_iterations;    // Iteraciones de subgradiente sobre π (0 = sin ascenso)
+    size_t exact_limit;          // Hasta este n: árbol y alfa exactos O(n²)
+    
+    OneTreeOptions() : num_candidates(5), ascent_iterations(0), exact_limit(5000) {}
+};
+
+class OneTree {
+private:
+    static constexpr uint32_t none = std::numeric_limits<uint32_t>::max();
+    static constexpr double infinity = std::numeric_limits<double>::max();
+    
+    size_t n_;
+    bool dense_;                       // Árbol sobre el grafo completo o sobre Delaunay
+    DelaunayTriangulation triangulation_;
+    std::vector<double> pi_;           // Penalizaciones por ciudad
+    std::vector<uint32_t> dad_;        // Padre en el árbol (none en la raíz)
+    std::vector<double> cost_;         // c(v, dad_[v])
+    std::vector<uint32_t> order_;      // Orden de inserción de Prim (padre antes que hijo)
+    std::vector<uint32_t> depth_;
+    std::vector<uint32_t> jump_;       // Ancestro de salto (punteros skew-binary)
+    std::vector<double> jump_max_;     // Arista más larga entre v y jump_[v]
+    std::vector<int> degree_;          // Grado en el 1-árbol
+    uint32_t special_;                 // Hoja que recibe la arista extra
+    uint32_t special_tree_;            // Su vecino en el árbol
+    uint32_t special_next_;            // Extremo de la arista extra
+    double special_cost_;              // Costo de la arista extra (la mayor de las dos)
+    double length_;                    // Longitud transformada del 1-árbol
+    double bound_;                     // Mejor w(π) encontrado
+    size_t iterations_done_;
+    
+    double cost(const PointSet& points, uint32_t i, uint32_t j) const {
+        return distance(points, i, j) + pi_[i] + pi_[j];
+    }
+    
+    // Prim O(n²) sobre el grafo completo. Las ciudades fuera del árbol se
+    // mantienen compactadas al frente de arreglos propios (coordenadas, π,
+    // clave, padre), así que cada barrido es lineal y sin saltos: la
+    // actualización de claves se vectoriza y la búsqueda del mínimo no
+    // calcula raíces.
+    void dense_spanning_tree(const PointSet& points) {
+        std::vector<uint32_t> id(n_), from(n_, none);
+        std::vector<double> xs(points.xs), ys(points.ys), pi(pi_), key(n_, infinity);
+        for (uint32_t v = 0; v < n_; ++v) id[v] = v;
+        size_t remaining = n_;
+        size_t slot = 0;   // La raíz es la ciudad 0
+        while (remaining > 0) {
+            uint32_t u = id[slot];
+            dad_[u] = from[slot];
+            cost_[u] = from[slot] == none ? 0.0 : key[slot];
+            order_.push_back(u);
+            
+            remaining--;
+            id[slot] = id[remaining];
+            from[slot] = from[remaining];
+            xs[slot] = xs[remaining];
+            ys[slot] = ys[remaining];
+            pi[slot] = pi[remaining];
+            key[slot] = key[remaining];
+            if (remaining == 0) break;
+            
+            double ux = points.xs[u], uy = points.ys[u], upi = pi_[u];
+            for (size_t s = 0; s < remaining; ++s) {
+                double dx = xs[s] - ux, dy = ys[s] - uy;
+                double c = std::sqrt(dx * dx + dy * dy) + upi + pi[s];
+                bool closer = c < key[s];
+                key[s] = closer ? c : key[s];
+                from[s] = closer ? u : from[s];
+            }
+            slot = 0;
+            for (size_t s = 1; s < remaining; ++s) {
+                if (key[s] < key[slot]) slot = s;
+            }
+        }
+    }
+    
+    // Arista más barata de leaf en el grafo completo sin contar skip. El
+    // índice se elige en la misma pasada que el mínimo: recalcular el costo en
+    // otra pasada puede no dar el mismo valor en punto flotante.
+    std::pair<double, uint32_t> dense_nearest(const PointSet& points, uint32_t leaf, uint32_t skip) const {
+        double lx = points.xs[leaf], ly = points.ys[leaf];
+        double best = infinity;
+        uint32_t at = none;
+        for (uint32_t u = 0; u < n_; ++u) {
+            double dx = points.xs[u] - lx, dy = points.ys[u] - ly;
+            double c = std::sqrt(dx * dx + dy * dy) + pi_[u];
+            bool closer = u != leaf && u != skip && c < best;
+            best = closer ? c : best;
+            at = closer ? u : at;
+        }
+        return {best + pi_[leaf], at};
+    }
+    
+    // Prim con heap sobre las aristas de Delaunay
+    void sparse_spanning_tree(const PointSet& points) {
+        std::vector<uint8_t> in_tree(n_, 0);
+        std::priority_queue<std::pair<double, std::pair<uint32_t, uint32_t>>,
+                            std::vector<std::pair<double, std::pair<uint32_t, uint32_t>>>,
+                            std::greater<>> heap;
+        heap.push({0.0, {0, none}});
+        while (!heap.empty()) {
+            auto [c, edge] = heap.top();
+            heap.pop();
+            uint32_t v = edge.first;
+            if (in_tree[v]) continue;
+            in_tree[v] = 1;
+            dad_[v] = edge.second;
+            cost_[v] = edge.second == none ? 0.0 : c;
+            order_.push_back(v);
+            for (uint32_t u : triangulation_.neighbors(v)) {
+                if (!in_tree[u]) heap.push({cost(points, v, u), {u, v}});
+            }
+        }
+    }
+    
+    // Vecino del árbol de una hoja: su padre o, si es la raíz, su único hijo
+    uint32_t tree_neighbor(uint32_t leaf) const {
+        return dad_[leaf] != none ? dad_[leaf] : order_[1];
+    }
+    
+    // Árbol mínimo + arista extra en la hoja cuya segunda arista es más larga.
+    // Devuelve w(π).
+    double compute_one_tree(const PointSet& points) {
+        dad_.assign(n_, none);
+        cost_.assign(n_, 0.0);
+        order_.clear();
+        if (dense_) dense_spanning_tree(points); else sparse_spanning_tree(points);
+        
+        degree_.assign(n_, 0);
+        depth_.assign(n_, 0);
+        jump_.resize(n_);
+        jump_max_.resize(n_);
+        length_ = 0;
+        for (uint32_t v : order_) {
+            uint32_t p = dad_[v];
+            if (p == none) {
+                jump_[v] = v;
+                jump_max_[v] = -infinity;
+                continue;
+            }
+            degree_[v]++;
+            degree_[p]++;
+            depth_[v] = depth_[p] + 1;
+            length_ += cost_[v];
+            
+            // Salto doble si los dos saltos del padre miden lo mismo: cualquier
+            // ancestro queda a O(log n) saltos con un solo puntero por nodo
+            uint32_t j = jump_[p];
+            if (depth_[p] - depth_[j] == depth_[j] - depth_[jump_[j]]) {
+                jump_[v] = jump_[j];
+                jump_max_[v] = std::max(cost_[v], std::max(jump_max_[p], jump_max_[j]));
+            } else {
+                jump_[v] = p;
+                jump_max_[v] = cost_[v];
+            }
+        }
+        
+        special_ = none;
+        special_cost_ = -infinity;
+        for (uint32_t leaf = 0; leaf < n_; ++leaf) {
+            if (degree_[leaf] != 1) continue;
+            uint32_t skip = tree_neighbor(leaf);
+            uint32_t best = none;
+            double best_cost = infinity;
+            auto consider = [&](uint32_t u) {
+                if (u == leaf || u == skip) return;
+                double c = cost(points, leaf, u);
+                if (c < best_cost) {
+                    best_cost = c;
+                    best = u;
+                }
+            };
+            if (dense_) {
+                std::tie(best_cost, best) = dense_nearest(points, leaf, skip);
+            } else {
+                for (uint32_t u : triangulation_.neighbors(leaf)) consider(u);
+            }
+            if (best != none && best_cost > special_cost_) {
+                special_ = leaf;
+                special_tree_ = skip;
+                special_next_ = best;
+                special_cost_ = best_cost;
+            }
+        }
+        if (special_ != none) {
+            degree_[special_]++;
+            degree_[special_next_]++;
+            length_ += special_cost_;
+        }
+        
+        double pi_sum = 0;
+        for (double p : pi_) pi_sum += p;
+        return length_ - 2 * pi_sum;
+    }
+    
+    // alfa de una arista que toca la hoja especial: reemplaza la arista extra
+    double special_alpha(const PointSet& points, uint32_t other) const {
+        if (other == special_tree_ || other == special_next_) return 0.0;
+        return cost(points, special_, other) - special_cost_;
+    }
+    
+    // Arista más larga del camino del árbol entre i y j: se igualan las
+    // profundidades y se sube en paralelo, saltando mientras no se pase del
+    // ancestro común. O(log n).
+    double path_max(uint32_t i, uint32_t j) const {
+        double best = -infinity;
+        if (depth_[i] < depth_[j]) std::swap(i, j);
+        while (depth_[i] > depth_[j]) {
+            if (depth_[jump_[i]] >= depth_[j]) {
+                best = std::max(best, jump_max_[i]);
+                i = jump_[i];
+            } else {
+                best = std::max(best, cost_[i]);
+                i = dad_[i];
+            }
+        }
+        while (i != j) {
+            if (jump_[i] != jump_[j]) {
+                best = std::max(best, std::max(jump_max_[i], jump_max_[j]));
+                i = jump_[i];
+                j = jump_[j];
+            } else {
+                best = std::max(best, std::max(cost_[i], cost_[j]));
+                i = dad_[i];
+                j = dad_[j];
+            }
+        }
+        return best;
+    }
+    
+    // Subgradiente: π_i += t (0.7 v_i + 0.3 v_i anterior) con v_i = grado - 2.
+    // El paso parte de la mitad del costo medio de una arista y se reduce a la
+    // mitad en cada octavo de las iteraciones; se conserva el π de la mejor cota.
+    void ascent(const PointSet& points, size_t iterations) {
+        std::vector<int> last_v(n_, 0);
+        std::vector<double> best_pi = pi_;
+        double step = 0.5 * length_ / n_;
+        size_t period = std::max<size_t>(1, iterations / 8);
+        for (iterations_done_ = 0; iterations_done_ < iterations; ++iterations_done_) {
+            bool is_tour = true;
+            for (uint32_t i = 0; i < n_; ++i) {
+                int v = degree_[i] - 2;
+                if (v != 0) is_tour = false;
+                pi_[i] += step * (0.7 * v + 0.3 * last_v[i]);
+                last_v[i] = v;
+            }
+            if (is_tour) break;   // El 1-árbol ya es un tour: la cota es óptima
+            
+            double w = compute_one_tree(points);
+            if (w > bound_) {
+                bound_ = w;
+                best_pi = pi_;
+            }
+            if ((iterations_done_ + 1) % period == 0) step *= 0.5;
+        }
+        pi_ = best_pi;
+        compute_one_tree(points);
+    }
+    
+    // alfa de cualquier par: la hoja especial usa su propia regla
+    double alpha(const PointSet& points, uint32_t i, uint32_t j) const {
+        if (i == special_) return special_alpha(points, j);
+        if (j == special_) return special_alpha(points, i);
+        return cost(points, i, j) - path_max(i, j);
+    }
+    
+    // Heap acotado de los k mejores (alfa, costo, ciudad)
+    using Scored = std::tuple<double, double, uint32_t>;
+    static void offer(std::priority_queue<Scored>& best_k, size_t k, const Scored& candidate) {
+        if (best_k.size() < k) {
+            best_k.push(candidate);
+        } else if (candidate < best_k.top()) {
+            best_k.pop();
+            best_k.push(candidate);
+        }
+    }
+
+public:
+    OneTree() : n_(0), dense_(true), special_(none), special_tree_(none), special_next_(none),
+                special_cost_(0), length_(0), bound_(0), iterations_done_(0) {}
+    
+    void build(const PointSet& points, const OneTreeOptions& options = OneTreeOptions()) {
+        n_ = points.size();
+        dense_ = n_ <= options.exact_limit;
+        pi_.assign(n_, 0.0);
+        iterations_done_ = 0;
+        bound_ = 0;
+        if (n_ < 3) {
+            // Sin 1-árbol: el único tour posible es la cota
+            bound_ = n_ == 2 ? 2 * distance(points, 0, 1) : 0.0;
+            return;
+        }
+        if (!dense_) triangulation_.build(points);
+        
+        bound_ = compute_one_tree(points);
+        if (options.ascent_iterations > 0) ascent(points, options.ascent_iterations);
+    }
+    
+    size_t size() const { return n_; }
+    double lower_bound() const { return bound_; }
+    
+    // w(π) con el π actual sobre el grafo completo (O(n²)). Con π ≠ 0 el árbol
+    // mínimo sobre Delaunay puede no ser el del grafo completo, así que su cota
+    // no está garantizada; esta sí.
+    double exact_lower_bound(const PointSet& points) {
+        if (n_ < 3 || dense_) return bound_;
+        dense_ = true;
+        double w = compute_one_tree(points);
+        dense_ = false;
+        compute_one_tree(points);
+        return w;
+    }
+    double one_tree_length() const { return length_; }
+    size_t ascent_iterations_done() const { return iterations_done_; }
+    const std::vector<double>& penalties() const { return pi_; }
+    
+    // Los K candidatos de menor alfa de cada ciudad (empates por costo), en el
+    // formato plano de CandidateLists. Las listas quedan ordenadas por alfa y
+    // no por distancia: los cortes tempranos de DLB/LK pasan a ser heurísticos,
+    // igual que en LKH.
+    void to_candidates(const PointSet& points, CandidateLists& candidates, size_t num_candidates) const {
+        candidates.k = std::min(num_candidates, n_ > 0 ? n_ - 1 : 0);
+        candidates.neighbors.assign(n_ * candidates.k, 0);
+        candidates.counts.assign(n_, 0);
+        candidates.nodes_visited = 0;
+        size_t k = candidates.k;
+        if (k == 0) return;
+        
+        std::vector<double> beta(n_);
+        std::vector<uint32_t> mark(n_, none);
+        std::priority_queue<Scored> best_k;
+        for (uint32_t i = 0; i < n_; ++i) {
+            if (n_ < 3) {
+                for (uint32_t j = 0; j < n_; ++j) {
+                    if (j != i) offer(best_k, k, {0.0, cost(points, i, j), j});
+                }
+            } else if (!dense_) {
+                // Vecinos de Delaunay a uno y dos saltos (mark evita repetidos)
+                mark[i] = i;
+                auto visit = [&](uint32_t j) {
+                    if (mark[j] == i) return;
+                    mark[j] = i;
+                    offer(best_k, k, {alpha(points, i, j), cost(points, i, j), j});
+                };
+                for (uint32_t u : triangulation_.neighbors(i)) {
+                    visit(u);
+                    for (uint32_t w : triangulation_.neighbors(u)) visit(w);
+                }
+            } else if (i == special_) {
+                for (uint32_t j = 0; j < n_; ++j) {
+                    if (j != i) offer(best_k, k, {special_alpha(points, j), cost(points, i, j), j});
+                }
+            } else {
+                // Beta a lo largo del árbol: primero el camino de i a la raíz,
+                // luego el resto en orden topológico (O(n) por ciudad)
+                beta[i] = -infinity;
+                mark[i] = i;
+                for (uint32_t u = i; dad_[u] != none; u = dad_[u]) {
+                    beta[dad_[u]] = std::max(beta[u], cost_[u]);
+                    mark[dad_[u]] = i;
+                }
+                for (uint32_t j : order_) {
+                    if (j == i) continue;
+                    if (mark[j] != i) beta[j] = std::max(beta[dad_[j]], cost_[j]);
+                    double c = cost(points, i, j);
+                    offer(best_k, k, {j == special_ ? special_alpha(points, i) : c - beta[j], c, j});
+                }
+            }
+            
+            uint32_t* out = candidates.neighbors.data() + static_cast<size_t>(i) * k;
+            uint32_t count = static_cast<uint32_t>(best_k.size());
+            for (uint32_t c = count; c-- > 0; best_k.pop()) out[c] = std::get<2>(best_k.top());
+            candidates.counts[i] = count;
+        }
+    }
+};
+
+// Cota inferior de Held-Karp: ascenso por subgradiente sobre el grafo disperso
+// de Delaunay (O(n log n) por iteración). Hasta exact_limit ciudades w(π) se
+// evalúa al final con el mejor π sobre el grafo completo (Prim denso, O(n²)
+// tiempo y O(n) memoria) y es una cota válida. Por encima se devuelve la del
+// grafo disperso con exact = false: con π ≠ 0 el 1-árbol sobre Delaunay puede
+// no ser mínimo en el grafo completo y sobreestimar la cota (~0.5% en
+// instancias de 6000-10000 ciudades), así que no sirve para gaps ni objetivos.
+struct HeldKarpBound {
+    double value;   // w(π) con el mejor π
+    bool exact;     // Evaluada sobre el grafo completo (cota garantizada)
+};
+
+inline HeldKarpBound held_karp_bound(const PointSet& points, size_t iterations = 100, size_t exact_limit = 5000) {
+    OneTreeOptions options;
+    options.exact_limit = 0;
+    options.ascent_iterations = iterations;
+    OneTree one_tree;
+    one_tree.build(points, options);
+    if (points.size() > exact_limit) return {one_tree.lower_bound(), false};
+    return {one_tree.exact_lower_bound(points), true};
+}
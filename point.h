@@ -1,16 +1,17 @@
 #pragma once
+#include "tour.h"
 #include <cmath>
+#include <cstdint>
 #include <vector>
 #include <random>
 #include <algorithm>
 #include <limits>
 
+// Coordenadas de un punto (valor ligero para consultas y cálculos puntuales)
 struct Point {
     double x, y;
-    bool active;  // Para el 2-opt aproximado
-    size_t id;    // Identificador único para tracking
     
-    Point(double x = 0, double y = 0, size_t id = 0) : x(x), y(y), active(true), id(id) {}
+    Point(double x = 0, double y = 0) : x(x), y(y) {}
     
     // Operadores para comparación
     bool operator==(const Point& other) const {
@@ -28,6 +29,31 @@ struct Point {
     }
 };
 
+// Conjunto de puntos en formato SoA: coordenadas contiguas en xs[] / ys[].
+// El identificador de cada punto es su índice.
+struct PointSet {
+    std::vector<double> xs;
+    std::vector<double> ys;
+    
+    PointSet() = default;
+    explicit PointSet(size_t n) : xs(n), ys(n) {}
+    
+    size_t size() const { return xs.size(); }
+    bool empty() const { return xs.empty(); }
+    
+    void reserve(size_t n) {
+        xs.reserve(n);
+        ys.reserve(n);
+    }
+    
+    void push_back(double x, double y) {
+        xs.push_back(x);
+        ys.push_back(y);
+    }
+    
+    Point operator[](size_t i) const { return Point(xs[i], ys[i]); }
+};
+
 // Distancia euclidiana
 inline double distance(const Point& a, const Point& b) {
     return std::sqrt((a.x - b.x)*(a.x - b.x) + (a.y - b.y)*(a.y - b.y));
@@ -38,23 +64,40 @@ inline double distance_squared(const Point& a, const Point& b) {
     return (a.x - b.x)*(a.x - b.x) + (a.y - b.y)*(a.y - b.y);
 }
 
+// Distancia euclidiana entre dos puntos del conjunto (por índice)
+inline double distance(const PointSet& points, size_t a, size_t b) {
+    double dx = points.xs[a] - points.xs[b];
+    double dy = points.ys[a] - points.ys[b];
+    return std::sqrt(dx * dx + dy * dy);
+}
+
+// Distancia euclidiana cuadrada entre dos puntos del conjunto (por índice)
+inline double distance_squared(const PointSet& points, size_t a, size_t b) {
+    double dx = points.xs[a] - points.xs[b];
+    double dy = points.ys[a] - points.ys[b];
+    return dx * dx + dy * dy;
+}
+
 // Genera puntos aleatorios en [0,1]x[0,1]
-inline std::vector<Point> generate_random_points(size_t n, unsigned int seed = 42) {
-    std::vector<Point> points;
+inline PointSet generate_random_points(size_t n, unsigned int seed = 42) {
+    PointSet points;
     points.reserve(n);
     
     std::mt19937 gen(seed);
     std::uniform_real_distribution<double> dist(0.0, 1.0);
     
     for (size_t i = 0; i < n; ++i) {
-        points.emplace_back(dist(gen), dist(gen), i);
+        // Orden de extracción conservado respecto a la versión AoS (y antes que x)
+        double y = dist(gen);
+        double x = dist(gen);
+        points.push_back(x, y);
     }
     return points;
 }
 
 // Genera puntos en cluster (más realista para TSP)
-inline std::vector<Point> generate_clustered_points(size_t n, size_t num_clusters = 5, unsigned int seed = 42) {
-    std::vector<Point> points;
+inline PointSet generate_clustered_points(size_t n, size_t num_clusters = 5, unsigned int seed = 42) {
+    PointSet points;
     points.reserve(n);
     
     std::mt19937 gen(seed);
@@ -65,7 +108,9 @@ inline std::vector<Point> generate_clustered_points(size_t n, size_t num_cluster
     // Generar centros de clusters
     std::vector<std::pair<double, double>> cluster_centers;
     for (size_t i = 0; i < num_clusters; ++i) {
-        cluster_centers.emplace_back(cluster_center(gen), cluster_center(gen));
+        double cy = cluster_center(gen);
+        double cx = cluster_center(gen);
+        cluster_centers.emplace_back(cx, cy);
     }
     
     for (size_t i = 0; i < n; ++i) {
@@ -78,33 +123,34 @@ inline std::vector<Point> generate_clustered_points(size_t n, size_t num_cluster
         double x = std::max(0.0, std::min(1.0, cx + cluster_point(gen)));
         double y = std::max(0.0, std::min(1.0, cy + cluster_point(gen)));
         
-        points.emplace_back(x, y, i);
+        points.push_back(x, y);
     }
     return points;
 }
 
 // Calcula la longitud total de un tour
-inline double tour_length(const std::vector<Point>& tour) {
+inline double tour_length(const PointSet& points, const Tour& tour) {
     if (tour.size() < 2) return 0.0;
     
     double length = 0.0;
-    for (size_t i = 0; i < tour.size(); ++i) {
-        length += distance(tour[i], tour[(i + 1) % tour.size()]);
+    for (size_t i = 0; i + 1 < tour.size(); ++i) {
+        length += distance(points, tour[i], tour[i + 1]);
     }
+    length += distance(points, tour[tour.size() - 1], tour[0]);
     return length;
 }
 
 // Heurística Nearest Neighbor para inicialización del tour
-inline std::vector<Point> nearest_neighbor_tour(const std::vector<Point>& points, size_t start_idx = 0) {
+inline Tour nearest_neighbor_tour(const PointSet& points, size_t start_idx = 0) {
     if (points.empty()) return {};
     
-    std::vector<Point> tour;
+    std::vector<uint32_t> order;
     std::vector<bool> visited(points.size(), false);
-    tour.reserve(points.size());
+    order.reserve(points.size());
     
     // Comenzar desde el punto especificado
     size_t current = start_idx;
-    tour.push_back(points[current]);
+    order.push_back(static_cast<uint32_t>(current));
     visited[current] = true;
     
     // Construir el tour
@@ -112,10 +158,11 @@ inline std::vector<Point> nearest_neighbor_tour(const std::vector<Point>& points
         double min_dist = std::numeric_limits<double>::max();
         size_t next = current;
         
-        // Encontrar el punto más cercano no visitado
+        // Encontrar el punto más cercano no visitado (distancia al cuadrado: el
+        // mismo orden y desempate por menor índice que el K-d tree)
         for (size_t i = 0; i < points.size(); ++i) {
             if (!visited[i]) {
-                double dist = distance(points[current], points[i]);
+                double dist = distance_squared(points, current, i);
                 if (dist < min_dist) {
                     min_dist = dist;
                     next = i;
@@ -123,31 +170,31 @@ inline std::vector<Point> nearest_neighbor_tour(const std::vector<Point>& points
             }
         }
         
-        tour.push_back(points[next]);
+        order.push_back(static_cast<uint32_t>(next));
         visited[next] = true;
         current = next;
     }
     
-    return tour;
+    return Tour(std::move(order));
 }
 
 // Genera múltiples tours NN desde diferentes puntos de inicio y retorna el mejor
-inline std::vector<Point> best_nearest_neighbor_tour(const std::vector<Point>& points, size_t num_starts = 10) {
+inline Tour best_nearest_neighbor_tour(const PointSet& points, size_t num_starts = 10) {
     if (points.empty()) return {};
     
-    std::vector<Point> best_tour;
+    Tour best_tour;
     double best_length = std::numeric_limits<double>::max();
     
     // Probar diferentes puntos de inicio
     for (size_t start = 0; start < std::min(num_starts, points.size()); ++start) {
-        auto tour = nearest_neighbor_tour(points, start);
-        double length = tour_length(tour);
+        Tour tour = nearest_neighbor_tour(points, start);
+        double length = tour_length(points, tour);
         
         if (length < best_length) {
             best_length = length;
-            best_tour = tour;
+            best_tour = std::move(tour);
         }
     }
     
     return best_tour;
-} 
\ No newline at end of file
+}
@@ -0,0 +1,101 @@
+#pragma once
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <functional>
+#include <cstddef>
+#include <cstdint>
+#include <algorithm>
+
+// Pool de hilos persistente para bucles paralelos por tareas.
+// parallel_for(num_tasks, fn) ejecuta fn(task, worker) para cada tarea en
+// [0, num_tasks), repartidas dinámicamente; el hilo llamador participa como
+// worker 0 y la llamada bloquea hasta que terminan todas las tareas. Los hilos
+// se crean una sola vez y se reutilizan entre llamadas (una por iteración).
+class ThreadPool {
+private:
+    std::vector<std::thread> workers_;
+    std::mutex mutex_;
+    std::condition_variable start_cv_;
+    std::condition_variable done_cv_;
+    
+    std::function<void(size_t, size_t)> job_;
+    size_t num_tasks_;
+    std::atomic<size_t> next_task_;
+    size_t pending_workers_;      // Workers que aún no terminaron la ronda actual
+    uint64_t generation_;         // Incrementa con cada parallel_for
+    bool stop_;
+    
+    void run_tasks(size_t worker) {
+        for (size_t task = next_task_++; task < num_tasks_; task = next_task_++) {
+            job_(task, worker);
+        }
+    }
+    
+    void worker_loop(size_t worker) {
+        uint64_t seen = 0;
+        while (true) {
+            {
+                std::unique_lock<std::mutex> lock(mutex_);
+                start_cv_.wait(lock, [&] { return stop_ || generation_ != seen; });
+                if (stop_) return;
+                seen = generation_;
+            }
+            
+            run_tasks(worker);
+            
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (--pending_workers_ == 0) done_cv_.notify_one();
+        }
+    }
+
+public:
+    // num_threads incluye al hilo llamador (0 = núcleos disponibles)
+    explicit ThreadPool(size_t num_threads)
+        : num_tasks_(0), next_task_(0), pending_workers_(0), generation_(0), stop_(false) {
+        if (num_threads == 0) num_threads = std::max(1u, std::thread::hardware_concurrency());
+        for (size_t w = 1; w < num_threads; ++w) {
+            workers_.emplace_back(&ThreadPool::worker_loop, this, w);
+        }
+    }
+    
+    ~ThreadPool() {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            stop_ = true;
+        }
+        start_cv_.notify_all();
+        for (std::thread& worker : workers_) worker.join();
+    }
+    
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+    
+    size_t size() const { return workers_.size() + 1; }
+    
+    template <class Fn>
+    void parallel_for(size_t num_tasks, Fn&& fn) {
+        if (workers_.empty()) {
+            for (size_t task = 0; task < num_tasks; ++task) fn(task, size_t(0));
+            return;
+        }
+        
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            job_ = std::ref(fn);
+            num_tasks_ = num_tasks;
+            next_task_ = 0;
+            pending_workers_ = workers_.size();
+            ++generation_;
+        }
+        start_cv_.notify_all();
+        
+        run_tasks(0);
+        
+        std::unique_lock<std::mutex> lock(mutex_);
+        done_cv_.wait(lock, [&] { return pending_workers_ == 0; });
+        job_ = nullptr;
+    }
+};
@@ -0,0 +1,65 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include <numeric>
+#include <utility>
+
+// Tour representado como permutación de índices de ciudades.
+// order[k] es la ciudad en la posición k y pos[c] la posición de la ciudad c,
+// de modo que ubicar una ciudad en el tour es O(1).
+struct Tour {
+    std::vector<uint32_t> order;
+    std::vector<uint32_t> pos;
+
+    Tour() = default;
+
+    explicit Tour(std::vector<uint32_t> cities) : order(std::move(cities)), pos(order.size()) {
+        for (size_t k = 0; k < order.size(); ++k) {
+            pos[order[k]] = static_cast<uint32_t>(k);
+        }
+    }
+
+    // Tour 0, 1, ..., n-1
+    static Tour identity(size_t n) {
+        std::vector<uint32_t> cities(n);
+        std::iota(cities.begin(), cities.end(), 0u);
+        return Tour(std::move(cities));
+    }
+
+    size_t size() const { return order.size(); }
+    bool empty() const { return order.empty(); }
+
+    // Ciudad en la posición k
+    uint32_t operator[](size_t k) const { return order[k]; }
+
+    // Posición de una ciudad en el tour
+    uint32_t position(uint32_t city) const { return pos[city]; }
+
+    // Sucesor y predecesor de una ciudad en el sentido actual del tour
+    uint32_t next(uint32_t city) const {
+        uint32_t k = pos[city] + 1;
+        return order[k == order.size() ? 0 : k];
+    }
+
+    uint32_t prev(uint32_t city) const {
+        uint32_t k = pos[city];
+        return order[k == 0 ? order.size() - 1 : k - 1];
+    }
+
+    // true si b está en el camino a -> ... -> c recorrido hacia adelante
+    bool between(uint32_t a, uint32_t b, uint32_t c) const {
+        uint32_t pa = pos[a], pb = pos[b], pc = pos[c];
+        if (pa <= pc) return pa <= pb && pb <= pc;
+        return pb >= pa || pb <= pc;
+    }
+
+    // Intercambia las ciudades de dos posiciones manteniendo pos[] consistente
+    void swap_positions(size_t a, size_t b) {
+        uint32_t ca = order[a], cb = order[b];
+        order[a] = cb;
+        order[b] = ca;
+        pos[cb] = static_cast<uint32_t>(a);
+        pos[ca] = static_cast<uint32_t>(b);
+    }
+};
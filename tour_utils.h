@@ -1,20 +1,38 @@
 #pragma once
 #include "point.h"
+#include "tour.h"
+#include "edge_cache.h"
 #include <vector>
 #include <algorithm>
-#include <unordered_map>
+#include <tuple>
+#include <queue>
+#include <functional>
 
 // Reversión eficiente de un segmento del tour
-inline void reverse_segment(std::vector<Point>& tour, size_t start, size_t end) {
+inline void reverse_segment(Tour& tour, size_t start, size_t end) {
     while (start < end) {
-        std::swap(tour[start], tour[end]);
+        tour.swap_positions(start, end);
         start++;
         end--;
     }
 }
 
+// Reversión circular de `len` posiciones comenzando en `start` (con wrap-around)
+inline void reverse_circular(Tour& tour, size_t start, size_t len) {
+    size_t n = tour.size();
+    if (len < 2) return;
+    
+    size_t left = start;
+    size_t right = (start + len - 1) % n;
+    for (size_t k = 0; k < len / 2; ++k) {
+        tour.swap_positions(left, right);
+        left = (left + 1 == n) ? 0 : left + 1;
+        right = (right == 0) ? n - 1 : right - 1;
+    }
+}
+
 // Reversión inteligente: reversar el segmento más corto para minimizar operaciones
-inline void smart_reverse_segment(std::vector<Point>& tour, size_t i, size_t j) {
+inline void smart_reverse_segment(Tour& tour, size_t i, size_t j) {
     size_t n = tour.size();
     
     // Asegurar que i < j
@@ -29,16 +47,89 @@ inline void smart_reverse_segment(std::vector<Point>& tour, size_t i, size_t j)
         // Reversión directa del segmento [i, j]
         reverse_segment(tour, i, j);
     } else {
-        // Reversión wrap-around: reversar todo excepto [i, j]
-        // Esto es equivalente a reversar [j+1, i-1] con wrap-around
-        std::reverse(tour.begin(), tour.begin() + i);
-        std::reverse(tour.begin() + j + 1, tour.end());
-        std::reverse(tour.begin(), tour.end());
+        // Reversión wrap-around del complemento [j+1, i-1]: produce el mismo
+        // tour cíclico (recorrido en sentido opuesto)
+        reverse_circular(tour, (j + 1) % n, wrap_length);
     }
 }
 
+// Reversa el camino from -> ... -> to (ciudades, recorrido hacia adelante)
+inline void reverse_path(Tour& tour, uint32_t from, uint32_t to) {
+    size_t n = tour.size();
+    size_t i = tour.position(from);
+    size_t j = tour.position(to);
+    size_t length = (j + n - i) % n + 1;
+    
+    if (length <= n - length) {
+        reverse_circular(tour, i, length);
+    } else {
+        reverse_circular(tour, (j + 1) % n, n - length);
+    }
+}
+
+// Ciudades en orden de recorrido desde `start`, para cualquier representación
+// de tour con next() (Tour o TwoLevelTour)
+template <class TourT>
+inline std::vector<uint32_t> tour_sequence(const TourT& tour, uint32_t start = 0) {
+    std::vector<uint32_t> cities;
+    cities.reserve(tour.size());
+    uint32_t city = start;
+    for (size_t k = 0; k < tour.size(); ++k) {
+        cities.push_back(city);
+        city = tour.next(city);
+    }
+    return cities;
+}
+
+// Movimiento 2-opt expresado con ciudades: elimina (a,b) y (c,d), agrega (a,c) y (b,d).
+// b debe ser vecino de a y d vecino de c en el mismo sentido (ambos sucesores
+// o ambos predecesores); funciona sin importar la orientación actual del tour.
+template <class TourT>
+inline void make_2opt_move(TourT& tour, uint32_t a, uint32_t b, uint32_t c, uint32_t d) {
+    (void)d;
+    if (tour.next(a) == b) {
+        reverse_path(tour, b, c);   // a b ... c d  ->  a c ... b d
+    } else {
+        reverse_path(tour, c, b);   // d c ... b a  ->  d b ... c a
+    }
+}
+
+// Movimiento Or-opt: reubica el segmento s1..s2 (con p -> s1 ... s2 -> nx) entre
+// las ciudades adyacentes c -> d, invertido o no, mediante hasta tres movimientos
+// 2-opt. (c, d) no debe tocar el segmento y el sentido debe coincidir con el de p -> s1.
+template <class TourT>
+inline void make_or_opt_move(TourT& tour, uint32_t s1, uint32_t s2, uint32_t p, uint32_t nx,
+                             uint32_t c, uint32_t d, bool reversed) {
+    if (d == p) {
+        // En el sentido opuesto el destino queda justo a continuación del segmento
+        make_or_opt_move(tour, s2, s1, nx, p, d, c, reversed);
+        return;
+    }
+    
+    make_2opt_move(tour, p, s1, c, d);             // p c ... nx s2..s1 d
+    if (c != nx) {
+        make_2opt_move(tour, p, c, nx, s2);        // p nx ... c s2..s1 d
+    }
+    if (!reversed && s1 != s2) {
+        make_2opt_move(tour, c, s2, s1, d);        // c s1..s2 d
+    }
+}
+
+// Bloque de posiciones (inicio, largo), circular, que reversa
+// make_2opt_move(tour, a, b, c, d) sobre un Tour: el mismo que elige reverse_path
+inline std::pair<size_t, size_t> reversed_block(const Tour& tour, uint32_t a, uint32_t b, uint32_t c) {
+    bool forward = tour.next(a) == b;
+    size_t n = tour.size();
+    size_t i = tour.position(forward ? b : c);
+    size_t j = tour.position(forward ? c : b);
+    size_t length = (j + n - i) % n + 1;
+    
+    if (length <= n - length) return {i, length};
+    return {(j + 1) % n, n - length};
+}
+
 // Realiza un swap 2-opt en el tour usando reversión inteligente
-inline void perform_2opt_swap(std::vector<Point>& tour, size_t i, size_t j) {
+inline void perform_2opt_swap(Tour& tour, size_t i, size_t j) {
     // Asegurarse de que i < j
     if (i > j) std::swap(i, j);
     
@@ -47,7 +138,7 @@ inline void perform_2opt_swap(std::vector<Point>& tour, size_t i, size_t j) {
 }
 
 // Calcula la ganancia de un swap 2-opt sin modificar el tour
-inline double calculate_2opt_gain(const std::vector<Point>& tour, size_t i, size_t j) {
+inline double calculate_2opt_gain(const PointSet& points, const Tour& tour, size_t i, size_t j) {
     size_t n = tour.size();
     
     // Asegurar que i < j
@@ -57,20 +148,24 @@ inline double calculate_2opt_gain(const std::vector<Point>& tour, size_t i, size
     if (j <= i + 1 || (i == 0 && j == n - 1)) return 0.0;
     
     // Calcular aristas actuales y nuevas
-    size_t i_next = (i + 1) % n;
-    size_t j_next = (j + 1) % n;
+    uint32_t a = tour[i];
+    uint32_t b = tour[(i + 1) % n];
+    uint32_t c = tour[j];
+    uint32_t d = tour[(j + 1) % n];
     
     // Distancias actuales
-    double old_dist = distance(tour[i], tour[i_next]) + distance(tour[j], tour[j_next]);
+    double old_dist = distance(points, a, b) + distance(points, c, d);
     
     // Distancias nuevas después del swap
-    double new_dist = distance(tour[i], tour[j]) + distance(tour[i_next], tour[j_next]);
+    double new_dist = distance(points, a, c) + distance(points, b, d);
     
     return old_dist - new_dist;
 }
 
-// Versión más eficiente usando distancias al cuadrado para comparaciones
-inline double calculate_2opt_gain_fast(const std::vector<Point>& tour, size_t i, size_t j) {
+// Misma ganancia con las aristas actuales tomadas de la caché: solo se
+// calculan las dos aristas nuevas (a, c) y (b, d)
+inline double calculate_2opt_gain(const PointSet& points, const Tour& tour, const EdgeCache& cache,
+                                  size_t i, size_t j) {
     size_t n = tour.size();
     
     // Asegurar que i < j
@@ -79,22 +174,29 @@ inline double calculate_2opt_gain_fast(const std::vector<Point>& tour, size_t i,
     // Validar índices
     if (j <= i + 1 || (i == 0 && j == n - 1)) return 0.0;
     
-    // Calcular aristas actuales y nuevas usando distancias al cuadrado
-    size_t i_next = (i + 1) % n;
-    size_t j_next = (j + 1) % n;
-    
-    // Distancias al cuadrado actuales
-    double old_dist_sq = distance_squared(tour[i], tour[i_next]) + distance_squared(tour[j], tour[j_next]);
+    uint32_t a = tour[i];
+    uint32_t b = tour[i + 1];
+    uint32_t c = tour[j];
+    uint32_t d = tour[j + 1 == n ? 0 : j + 1];
     
-    // Distancias al cuadrado nuevas después del swap
-    double new_dist_sq = distance_squared(tour[i], tour[j]) + distance_squared(tour[i_next], tour[j_next]);
+    return cache.length(a, b) + cache.length(c, d) - distance(points, a, c) - distance(points, b, d);
+}
+
+// Aplica el swap 2-opt (i, j) con perform_2opt_swap y actualiza la caché
+inline void perform_2opt_swap(const PointSet& points, Tour& tour, EdgeCache& cache, size_t i, size_t j) {
+    size_t n = tour.size();
+    if (i > j) std::swap(i, j);
     
-    return old_dist_sq - new_dist_sq;
+    uint32_t a = tour[i], b = tour[i + 1];
+    uint32_t c = tour[j], d = tour[j + 1 == n ? 0 : j + 1];
+    perform_2opt_swap(tour, i, j);
+    cache.apply_2opt(a, b, c, d, distance(points, a, c), distance(points, b, d));
 }
 
 // Encuentra el mejor swap 2-opt en un rango de puntos
 inline std::pair<size_t, size_t> find_best_2opt_swap(
-    const std::vector<Point>& tour,
+    const PointSet& points,
+    const Tour& tour,
     size_t start,
     size_t end,
     double min_gain = 0.0) {
@@ -106,7 +208,7 @@ inline std::pair<size_t, size_t> find_best_2opt_swap(
         for (size_t j = i + 2; j < end; ++j) {
             if (j == tour.size() - 1 && i == 0) continue;
             
-            double gain = calculate_2opt_gain(tour, i, j);
+            double gain = calculate_2opt_gain(points, tour, i, j);
             if (gain > best_gain) {
                 best_gain = gain;
                 best_swap = {i, j};
@@ -118,14 +220,15 @@ inline std::pair<size_t, size_t> find_best_2opt_swap(
 }
 
 // Calcula todas las mejoras posibles en un tour (para análisis)
-inline std::vector<std::tuple<size_t, size_t, double>> find_all_improvements(const std::vector<Point>& tour) {
+inline std::vector<std::tuple<size_t, size_t, double>> find_all_improvements(
+    const PointSet& points, const Tour& tour) {
     std::vector<std::tuple<size_t, size_t, double>> improvements;
     
-    for (size_t i = 0; i < tour.size() - 2; ++i) {
+    for (size_t i = 0; i + 2 < tour.size(); ++i) {
         for (size_t j = i + 2; j < tour.size(); ++j) {
             if (j == tour.size() - 1 && i == 0) continue;
             
-            double gain = calculate_2opt_gain(tour, i, j);
+            double gain = calculate_2opt_gain(points, tour, i, j);
             if (gain > 1e-9) { // Solo mejoras significativas
                 improvements.emplace_back(i, j, gain);
             }
@@ -141,20 +244,16 @@ inline std::vector<std::tuple<size_t, size_t, double>> find_all_improvements(con
     return improvements;
 }
 
-// Verifica si un tour es válido (todos los puntos únicos, cíclico)
-inline bool is_valid_tour(const std::vector<Point>& tour, const std::vector<Point>& original_points) {
-    if (tour.size() != original_points.size()) return false;
+// Verifica si un tour es válido (permutación de todas las ciudades con pos[] consistente)
+inline bool is_valid_tour(const Tour& tour, size_t num_points) {
+    if (tour.size() != num_points || tour.pos.size() != num_points) return false;
     
-    // Verificar que todos los puntos estén presentes
-    std::unordered_map<size_t, bool> seen;
-    for (const auto& point : tour) {
-        if (seen[point.id]) return false; // Punto duplicado
-        seen[point.id] = true;
-    }
-    
-    // Verificar que todos los puntos originales estén en el tour
-    for (const auto& point : original_points) {
-        if (!seen[point.id]) return false;
+    std::vector<bool> seen(num_points, false);
+    for (size_t k = 0; k < tour.size(); ++k) {
+        uint32_t city = tour[k];
+        if (city >= num_points || seen[city]) return false; // Fuera de rango o duplicado
+        if (tour.position(city) != k) return false;         // Índice inverso inconsistente
+        seen[city] = true;
     }
     
     return true;
@@ -165,41 +264,68 @@ inline double tour_improvement_ratio(double initial_length, double final_length)
     return (initial_length - final_length) / initial_length;
 }
 
-// Encuentra los segmentos más prometedores para optimización
-inline std::vector<std::pair<size_t, size_t>> find_promising_segments(
-    const std::vector<Point>& tour, 
-    size_t segment_size = 10,
-    size_t max_segments = 5) {
+// Longitud media de las aristas que salen de las posiciones [start, end)
+inline double segment_average_edge(const PointSet& points, const Tour& tour, size_t start, size_t end) {
+    size_t n = tour.size();
+    double segment_length = 0.0;
+    for (size_t i = start; i < end; ++i) {
+        segment_length += distance(points, tour[i], tour[(i + 1) % n]);
+    }
+    return segment_length / (end - start);
+}
+
+// Segmento [start, end) del tour con su longitud media de arista
+struct SegmentScore {
+    double score;
+    size_t start, end;
+};
+
+// Los max_segments segmentos de segment_size posiciones con mayor longitud
+// media, de peor a mejor. Un heap de mínimos acotado a max_segments evita
+// ordenar todos los segmentos (O(n log k)).
+inline std::vector<SegmentScore> score_promising_segments(
+    const PointSet& points,
+    const Tour& tour,
+    size_t segment_size,
+    size_t max_segments) {
     
-    std::vector<std::pair<size_t, size_t>> segments;
     size_t n = tour.size();
+    segment_size = std::max<size_t>(segment_size, 1);
     
-    // Dividir el tour en segmentos y evaluar la "promesa" de cada uno
-    std::vector<std::pair<double, std::pair<size_t, size_t>>> segment_promises;
+    // (promesa, (inicio, fin)) con la menor promesa arriba
+    using Entry = std::pair<double, std::pair<size_t, size_t>>;
+    std::priority_queue<Entry, std::vector<Entry>, std::greater<Entry>> best;
     
     for (size_t start = 0; start < n; start += segment_size) {
         size_t end = std::min(start + segment_size, n);
+        double promise = segment_average_edge(points, tour, start, end);
         
-        // Calcular una métrica de "promesa" basada en la longitud local
-        double segment_length = 0.0;
-        for (size_t i = start; i < end; ++i) {
-            segment_length += distance(tour[i], tour[(i + 1) % n]);
+        if (best.size() < max_segments) {
+            best.push({promise, {start, end}});
+        } else if (max_segments > 0 && promise > best.top().first) {
+            best.pop();
+            best.push({promise, {start, end}});
         }
-        
-        double promise = segment_length / (end - start); // Longitud promedio
-        segment_promises.emplace_back(promise, std::make_pair(start, end));
     }
     
-    // Ordenar por promesa descendente
-    std::sort(segment_promises.begin(), segment_promises.end(),
-              [](const auto& a, const auto& b) {
-                  return a.first > b.first;
-              });
-    
-    // Tomar los segmentos más prometedores
-    for (size_t i = 0; i < std::min(max_segments, segment_promises.size()); ++i) {
-        segments.push_back(segment_promises[i].second);
+    std::vector<SegmentScore> segments(best.size());
+    for (size_t i = segments.size(); i-- > 0; best.pop()) {
+        segments[i] = {best.top().first, best.top().second.first, best.top().second.second};
     }
+    return segments;
+}
+
+// Encuentra los segmentos más prometedores para optimización: los
+// max_segments de mayor longitud media, de peor a mejor
+inline std::vector<std::pair<size_t, size_t>> find_promising_segments(
+    const PointSet& points,
+    const Tour& tour, 
+    size_t segment_size = 10,
+    size_t max_segments = 5) {
     
+    std::vector<std::pair<size_t, size_t>> segments;
+    for (const SegmentScore& segment : score_promising_segments(points, tour, segment_size, max_segments)) {
+        segments.push_back({segment.start, segment.end});
+    }
     return segments;
-} 
\ No newline at end of file
+}
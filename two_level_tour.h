@@ -0,0 +1,261 @@
+#pragma once
+#include "point.h"
+#include "tour.h"
+#include <vector>
+#include <cmath>
+#include <algorithm>
+#include <cstdint>
+
+// Tour en lista de dos niveles: las ciudades se agrupan en bloques de ~√n con un
+// bit de reversión cada uno, y los bloques forman una secuencia circular.
+// next, prev y between son O(1); reverse_path (flip) cuesta O(√n): como mucho
+// dos divisiones de bloque más la reversión de una secuencia de bloques.
+// Los bloques solo se dividen, así que se reconstruyen cuando su número se
+// duplica (costo amortizado O(√n) por flip).
+class TwoLevelTour {
+private:
+    struct Block {
+        std::vector<uint32_t> items;   // Ciudades en orden almacenado
+        bool reversed;                 // Orden lógico = items invertido
+        uint32_t rank;                 // Posición en block_order_
+    };
+    
+    std::vector<Block> blocks_;
+    std::vector<uint32_t> block_order_;   // Secuencia circular de bloques
+    std::vector<uint32_t> block_of_;      // Bloque de cada ciudad
+    std::vector<uint32_t> index_of_;      // Índice de cada ciudad en items
+    size_t target_size_;                  // Tamaño de bloque tras reconstruir
+    
+    size_t block_size(uint32_t b) const { return blocks_[b].items.size(); }
+    
+    // Índice lógico de una ciudad dentro de su bloque
+    size_t logical_index(uint32_t city) const {
+        const Block& blk = blocks_[block_of_[city]];
+        size_t i = index_of_[city];
+        return blk.reversed ? blk.items.size() - 1 - i : i;
+    }
+    
+    uint32_t first_city(uint32_t b) const {
+        const Block& blk = blocks_[b];
+        return blk.reversed ? blk.items.back() : blk.items.front();
+    }
+    
+    uint32_t last_city(uint32_t b) const {
+        const Block& blk = blocks_[b];
+        return blk.reversed ? blk.items.front() : blk.items.back();
+    }
+    
+    uint32_t next_block(uint32_t b) const {
+        uint32_t r = blocks_[b].rank + 1;
+        return block_order_[r == block_order_.size() ? 0 : r];
+    }
+    
+    uint32_t prev_block(uint32_t b) const {
+        uint32_t r = blocks_[b].rank;
+        return block_order_[r == 0 ? block_order_.size() - 1 : r - 1];
+    }
+    
+    void reindex(uint32_t b, size_t from = 0) {
+        const std::vector<uint32_t>& items = blocks_[b].items;
+        for (size_t i = from; i < items.size(); ++i) {
+            block_of_[items[i]] = b;
+            index_of_[items[i]] = static_cast<uint32_t>(i);
+        }
+    }
+    
+    // Reparte la secuencia dada en bloques de target_size_ ciudades
+    void rebuild(const std::vector<uint32_t>& sequence) {
+        size_t n = sequence.size();
+        target_size_ = std::max<size_t>(8, static_cast<size_t>(std::sqrt(static_cast<double>(n))));
+        size_t num_blocks = (n + target_size_ - 1) / target_size_;
+        
+        blocks_.assign(num_blocks, Block());
+        block_order_.resize(num_blocks);
+        for (uint32_t b = 0; b < num_blocks; ++b) {
+            size_t begin = b * target_size_;
+            size_t end = std::min(n, begin + target_size_);
+            blocks_[b].items.assign(sequence.begin() + begin, sequence.begin() + end);
+            blocks_[b].reversed = false;
+            blocks_[b].rank = b;
+            block_order_[b] = b;
+            reindex(b);
+        }
+    }
+    
+    void rebuild() {
+        rebuild(sequence());
+    }
+    
+    // Divide el bloque de `city` para que `city` sea su primera ciudad lógica
+    void split_before(uint32_t city) {
+        uint32_t b = block_of_[city];
+        size_t split = logical_index(city);
+        if (split == 0) return;
+        
+        size_t size = block_size(b);
+        uint32_t nb = static_cast<uint32_t>(blocks_.size());
+        blocks_.push_back(Block());
+        Block& blk = blocks_[b];
+        Block& tail = blocks_[nb];
+        tail.reversed = blk.reversed;
+        
+        // La cola lógica [split, size) pasa al bloque nuevo
+        if (!blk.reversed) {
+            tail.items.assign(blk.items.begin() + split, blk.items.end());
+            blk.items.resize(split);
+        } else {
+            tail.items.assign(blk.items.begin(), blk.items.begin() + (size - split));
+            blk.items.erase(blk.items.begin(), blk.items.begin() + (size - split));
+            reindex(b);
+        }
+        reindex(nb);
+        
+        // Insertar el bloque nuevo a continuación de b
+        uint32_t rank = blk.rank + 1;
+        block_order_.insert(block_order_.begin() + rank, nb);
+        for (size_t r = rank; r < block_order_.size(); ++r) {
+            blocks_[block_order_[r]].rank = static_cast<uint32_t>(r);
+        }
+    }
+    
+    // Divide el bloque de `city` para que `city` sea su última ciudad lógica
+    void split_after(uint32_t city) {
+        if (last_city(block_of_[city]) == city) return;
+        split_before(next(city));
+    }
+    
+    // Invierte `count` bloques consecutivos de block_order_ desde el rango `start`
+    void reverse_blocks(size_t start, size_t count) {
+        size_t m = block_order_.size();
+        size_t left = start;
+        size_t right = (start + count - 1) % m;
+        for (size_t k = 0; k < count / 2; ++k) {
+            std::swap(block_order_[left], block_order_[right]);
+            left = (left + 1 == m) ? 0 : left + 1;
+            right = (right == 0) ? m - 1 : right - 1;
+        }
+        for (size_t k = 0, r = start; k < count; ++k, r = (r + 1 == m) ? 0 : r + 1) {
+            Block& blk = blocks_[block_order_[r]];
+            blk.reversed = !blk.reversed;
+            blk.rank = static_cast<uint32_t>(r);
+        }
+    }
+
+public:
+    TwoLevelTour() : target_size_(8) {}
+    
+    explicit TwoLevelTour(const Tour& tour) : target_size_(8) {
+        block_of_.resize(tour.size());
+        index_of_.resize(tour.size());
+        rebuild(tour.order);
+    }
+    
+    size_t size() const { return block_of_.size(); }
+    
+    uint32_t next(uint32_t city) const {
+        uint32_t b = block_of_[city];
+        const Block& blk = blocks_[b];
+        uint32_t i = index_of_[city];
+        if (!blk.reversed) {
+            if (i + 1 < blk.items.size()) return blk.items[i + 1];
+        } else {
+            if (i > 0) return blk.items[i - 1];
+        }
+        return first_city(next_block(b));
+    }
+    
+    uint32_t prev(uint32_t city) const {
+        uint32_t b = block_of_[city];
+        const Block& blk = blocks_[b];
+        uint32_t i = index_of_[city];
+        if (!blk.reversed) {
+            if (i > 0) return blk.items[i - 1];
+        } else {
+            if (i + 1 < blk.items.size()) return blk.items[i + 1];
+        }
+        return last_city(prev_block(b));
+    }
+    
+    // true si b está en el camino a -> ... -> c recorrido hacia adelante
+    bool between(uint32_t a, uint32_t b, uint32_t c) const {
+        auto key = [this](uint32_t city) {
+            return (static_cast<uint64_t>(blocks_[block_of_[city]].rank) << 32) | logical_index(city);
+        };
+        uint64_t ka = key(a), kb = key(b), kc = key(c);
+        if (ka <= kc) return ka <= kb && kb <= kc;
+        return kb >= ka || kb <= kc;
+    }
+    
+    // Reversa el camino from -> ... -> to (flip)
+    void reverse_path(uint32_t from, uint32_t to) {
+        if (from == to) return;
+        
+        uint32_t b = block_of_[from];
+        if (b == block_of_[to] && logical_index(from) <= logical_index(to)) {
+            // Camino dentro de un solo bloque: invertir el subrango de items
+            Block& blk = blocks_[b];
+            size_t lo = index_of_[from], hi = index_of_[to];
+            if (lo > hi) std::swap(lo, hi);
+            std::reverse(blk.items.begin() + lo, blk.items.begin() + hi + 1);
+            for (size_t i = lo; i <= hi; ++i) index_of_[blk.items[i]] = static_cast<uint32_t>(i);
+            return;
+        }
+        
+        split_before(from);
+        split_after(to);
+        
+        size_t m = block_order_.size();
+        size_t r_from = blocks_[block_of_[from]].rank;
+        size_t r_to = blocks_[block_of_[to]].rank;
+        size_t count = (r_to + m - r_from) % m + 1;
+        
+        // Invertir la secuencia más corta: el camino o su complemento
+        if (count <= m - count) {
+            reverse_blocks(r_from, count);
+        } else if (count < m) {
+            reverse_blocks((r_to + 1) % m, m - count);
+        }
+        
+        if (block_order_.size() > 2 * ((size() + target_size_ - 1) / target_size_) + 2) {
+            rebuild();
+        }
+    }
+    
+    // Ciudades en orden de recorrido a partir del primer bloque
+    std::vector<uint32_t> sequence() const {
+        std::vector<uint32_t> cities;
+        cities.reserve(size());
+        for (uint32_t b : block_order_) {
+            const Block& blk = blocks_[b];
+            if (!blk.reversed) {
+                cities.insert(cities.end(), blk.items.begin(), blk.items.end());
+            } else {
+                cities.insert(cities.end(), blk.items.rbegin(), blk.items.rend());
+            }
+        }
+        return cities;
+    }
+    
+    Tour to_tour() const {
+        return Tour(sequence());
+    }
+};
+
+// Reversión de camino para el tour de dos niveles (misma firma que para Tour)
+inline void reverse_path(TwoLevelTour& tour, uint32_t from, uint32_t to) {
+    tour.reverse_path(from, to);
+}
+
+// Longitud total de un tour de dos niveles
+inline double tour_length(const PointSet& points, const TwoLevelTour& tour) {
+    if (tour.size() < 2) return 0.0;
+    
+    double length = 0.0;
+    uint32_t city = 0;
+    for (size_t i = 0; i < tour.size(); ++i) {
+        uint32_t next = tour.next(city);
+        length += distance(points, city, next);
+        city = next;
+    }
+    return length;
+}
@@ -1,14 +1,21 @@
 #pragma once
 #include "point.h"
 #include "kd_tree.h"
+#include "candidates.h"
+#include "tour.h"
 #include "tour_utils.h"
+#include "gain_kernels.h"
+#include "thread_pool.h"
 #include <vector>
 #include <chrono>
-#include <unordered_set>
+#include <deque>
+#include <memory>
+#include <map>
+#include <queue>
+#include <tuple>
 #include <iostream>
 #include <iomanip>
 #include <algorithm>
-#include <random>
 
 struct OptimizationStats {
     double initial_length;
@@ -19,10 +26,36 @@ struct OptimizationStats {
     double cpu_time;
     size_t iterations;
     size_t active_nodes;         // Para versión aproximada
+    std::vector<size_t> thread_comparisons;   // Comparaciones por hilo (modo paralelo)
+    double lower_bound;          // Cota inferior de Held-Karp (0 = desconocida)
+    bool target_reached;         // Se detuvo al alcanzar la longitud objetivo
     
     OptimizationStats() : initial_length(0), final_length(0), num_swaps(0), 
                          num_visited(0), total_comparisons(0), cpu_time(0), 
-                         iterations(0), active_nodes(0) {}
+                         iterations(0), active_nodes(0), lower_bound(0), target_reached(false) {}
+    
+    // Distancia relativa a la cota: (tour - LB) / LB
+    double gap() const {
+        return lower_bound > 0 ? (final_length - lower_bound) / lower_bound : 0.0;
+    }
+    
+    // Acumula las métricas de una fase posterior aplicada sobre el mismo tour
+    void merge(const OptimizationStats& next) {
+        final_length = next.final_length;
+        num_swaps += next.num_swaps;
+        num_visited += next.num_visited;
+        total_comparisons += next.total_comparisons;
+        cpu_time += next.cpu_time;
+        iterations += next.iterations;
+        active_nodes = std::max(active_nodes, next.active_nodes);
+        target_reached = next.target_reached;
+        if (thread_comparisons.size() < next.thread_comparisons.size()) {
+            thread_comparisons.resize(next.thread_comparisons.size(), 0);
+        }
+        for (size_t t = 0; t < next.thread_comparisons.size(); ++t) {
+            thread_comparisons[t] += next.thread_comparisons[t];
+        }
+    }
     
     void print_detailed_stats(const std::string& algorithm_name) const {
         std::cout << "\n#stat " << algorithm_name << " Results:\n";
@@ -30,10 +63,22 @@ struct OptimizationStats {
         std::cout << "#stat Final Tour Length: " << final_length << "\n";
         std::cout << "#stat Improvement: " << std::setprecision(2) 
                   << (initial_length - final_length) / initial_length * 100.0 << "%\n";
+        if (lower_bound > 0) {
+            std::cout << "#stat Lower Bound (Held-Karp): " << std::setprecision(6) << lower_bound << "\n";
+            std::cout << "#stat Optimality Gap: " << std::setprecision(2) << gap() * 100.0 << "%"
+                      << (target_reached ? " (objetivo alcanzado)" : "") << "\n";
+        }
         std::cout << "#stat Total Swaps: " << num_swaps << "\n";
         std::cout << "#stat Total Iterations: " << iterations << "\n";
         std::cout << "#stat KD-Tree Nodes Visited: " << num_visited << "\n";
         std::cout << "#stat Total Comparisons: " << total_comparisons << "\n";
+        if (thread_comparisons.size() > 1) {
+            std::cout << "#stat Thread Comparisons:";
+            for (size_t t = 0; t < thread_comparisons.size(); ++t) {
+                std::cout << " t" << t << "=" << thread_comparisons[t];
+            }
+            std::cout << "\n";
+        }
         std::cout << "#stat CPU Time: " << std::setprecision(4) << cpu_time << " seconds\n";
         if (active_nodes > 0) {
             std::cout << "#stat Active Nodes (Approx): " << active_nodes << "\n";
@@ -45,360 +90,827 @@ struct OptimizationStats {
     }
 };
 
+// Opciones de los drivers de búsqueda local. Hilos y multi-movimiento son de los
+// drivers de mejor mejora (basic, geometric, hybrid); la longitud objetivo la
+// respetan todos (también DLB y Or-Opt): se detienen en cuanto el tour la alcanza.
+struct TwoOptOptions {
+    size_t num_threads;    // Hilos para la búsqueda exhaustiva (solo basic_2opt)
+    bool multi_move;       // Aplicar en cada pasada todos los swaps independientes
+    double target_length;  // Longitud objetivo, p. ej. LB * (1 + gap) (0 = sin objetivo)
+    
+    TwoOptOptions() : num_threads(1), multi_move(false), target_length(0) {}
+    
+    bool reached(double length) const { return target_length > 0 && length <= target_length; }
+};
+
+// Swap 2-opt candidato con i < j: reversa las posiciones i + 1 .. j
+struct SwapCandidate {
+    double gain;
+    size_t i, j;
+};
+
+// Modo multi-movimiento: de los swaps mejoradores de una pasada elige, en orden
+// de ganancia descendente (empates por menor (i, j)), un conjunto maximal con
+// intervalos [i, j] disjuntos. Cada swap solo lee las posiciones i, i + 1, j,
+// j + 1 y solo mueve i + 1 .. j, así que swaps disjuntos no se afectan: sus
+// ganancias se suman exactamente. Ordena `candidates` in situ.
+inline std::vector<SwapCandidate> select_disjoint_swaps(std::vector<SwapCandidate>& candidates) {
+    std::sort(candidates.begin(), candidates.end(), [](const SwapCandidate& x, const SwapCandidate& y) {
+        if (x.gain != y.gain) return x.gain > y.gain;
+        return x.i != y.i ? x.i < y.i : x.j < y.j;
+    });
+    
+    std::vector<SwapCandidate> selected;
+    std::map<size_t, size_t> taken;   // Intervalos aceptados: i -> j
+    for (const SwapCandidate& swap : candidates) {
+        auto next = taken.lower_bound(swap.i);
+        if (next != taken.end() && next->first <= swap.j) continue;
+        if (next != taken.begin() && std::prev(next)->second >= swap.i) continue;
+        taken.emplace(swap.i, swap.j);
+        selected.push_back(swap);
+    }
+    return selected;
+}
+
+// Aplica swaps disjuntos como movimientos por ciudades (make_2opt_move): la
+// reversión del complemento puede cambiar posiciones, pero no las aristas de
+// los demás swaps. Actualiza la caché de aristas si se proporciona.
+inline void apply_disjoint_swaps(const PointSet& points, Tour& tour,
+                                 const std::vector<SwapCandidate>& swaps, EdgeCache* cache = nullptr) {
+    size_t n = tour.size();
+    struct CityMove {
+        uint32_t a, b, c, d;
+    };
+    std::vector<CityMove> moves;
+    moves.reserve(swaps.size());
+    for (const SwapCandidate& swap : swaps) {
+        moves.push_back({tour[swap.i], tour[swap.i + 1], tour[swap.j], tour[swap.j + 1 == n ? 0 : swap.j + 1]});
+    }
+    
+    for (const CityMove& m : moves) {
+        make_2opt_move(tour, m.a, m.b, m.c, m.d);
+        if (cache) {
+            cache->apply_2opt(m.a, m.b, m.c, m.d, distance(points, m.a, m.c), distance(points, m.b, m.d));
+        }
+    }
+}
+
 // =============== ALGORITMO 2-OPT BÁSICO ===============
-inline OptimizationStats basic_2opt(std::vector<Point>& tour) {
+// Búsqueda exhaustiva con el kernel de ganancias por bloques (gain_kernels.h):
+// por cada fila i se obtiene el mejor j sobre coordenadas en orden de tour.
+// Con num_threads > 1 las filas se reparten en bloques contiguos de i con
+// aproximadamente el mismo número de pares (la fila i tiene n - i - 2).
+// La reducción recorre las filas en orden con ganancia estrictamente mayor, así
+// que ante empates gana el menor (i, j) y el resultado no depende de los hilos.
+// En modo multi-movimiento el mejor swap de cada fila es un candidato.
+inline OptimizationStats basic_2opt(const PointSet& points, Tour& tour,
+                                    const TwoOptOptions& options = TwoOptOptions(),
+                                    GainKernel kernel = detect_gain_kernel()) {
     OptimizationStats stats;
-    stats.initial_length = tour_length(tour);
+    stats.initial_length = tour_length(points, tour);
     
     auto start_time = std::chrono::high_resolution_clock::now();
     bool improved = true;
     const size_t max_iterations = 1000;
     const double min_improvement = 1e-9;
+    size_t n = tour.size();
+    size_t rows = n >= 2 ? n - 2 : 0;
+    TourCoords coords;
+    
+    // Mejor swap de cada fila (row_j[i] == n si la fila no mejora)
+    std::vector<double> row_gain(rows);
+    std::vector<size_t> row_j(rows);
+    
+    // Evalúa las filas [row_begin, row_end); devuelve las comparaciones
+    auto scan_rows = [&](size_t row_begin, size_t row_end) {
+        size_t comparisons = 0;
+        for (size_t i = row_begin; i < row_end; ++i) {
+            // j en [i + 2, n), sin el par (0, n - 1)
+            size_t end = (i == 0) ? n - 1 : n;
+            row_gain[i] = min_improvement;
+            row_j[i] = n;
+            best_2opt_in_row(kernel, coords, i, i + 2, end, row_gain[i], row_j[i]);
+            comparisons += end - (i + 2);
+        }
+        return comparisons;
+    };
     
-    while (improved && stats.iterations < max_iterations) {
+    // Bloques de filas balanceados por número de pares (forma triangular);
+    // varios bloques por hilo para repartir la carga dinámicamente
+    std::unique_ptr<ThreadPool> pool;
+    std::vector<size_t> chunk_begin;
+    if (options.num_threads != 1 && n > 3) {
+        pool = std::make_unique<ThreadPool>(options.num_threads);
+        size_t num_chunks = std::min(rows, pool->size() * 8);
+        double total_pairs = 0.5 * static_cast<double>(rows) * static_cast<double>(rows - 1);
+        
+        chunk_begin.push_back(0);
+        double pairs = 0;
+        for (size_t i = 0; i < rows && chunk_begin.size() < num_chunks; ++i) {
+            pairs += static_cast<double>(n - i - 2);
+            if (pairs >= total_pairs * chunk_begin.size() / num_chunks) chunk_begin.push_back(i + 1);
+        }
+        chunk_begin.push_back(rows);
+        stats.thread_comparisons.assign(pool->size(), 0);
+    }
+    
+    std::vector<SwapCandidate> candidates;
+    double length = stats.initial_length;   // Se descuenta la ganancia de cada swap
+    stats.target_reached = options.reached(length);
+    
+    while (improved && stats.iterations < max_iterations && !stats.target_reached) {
         improved = false;
         stats.iterations++;
+        coords.assign(points, tour);
         
-        double best_gain = min_improvement;
-        size_t best_i = 0, best_j = 0;
+        if (!pool) {
+            stats.total_comparisons += scan_rows(0, rows);
+        } else {
+            pool->parallel_for(chunk_begin.size() - 1, [&](size_t chunk, size_t worker) {
+                stats.thread_comparisons[worker] += scan_rows(chunk_begin[chunk], chunk_begin[chunk + 1]);
+            });
+        }
         
-        // Búsqueda exhaustiva del mejor swap
-        for (size_t i = 0; i < tour.size() - 2; ++i) {
-            for (size_t j = i + 2; j < tour.size(); ++j) {
-                if (j == tour.size() - 1 && i == 0) continue;
-                
-                double gain = calculate_2opt_gain(tour, i, j);
-                stats.total_comparisons++;
-                
-                if (gain > best_gain) {
-                    best_gain = gain;
+        if (options.multi_move) {
+            // Aplicar todos los swaps independientes de la pasada
+            candidates.clear();
+            for (size_t i = 0; i < rows; ++i) {
+                if (row_j[i] != n) candidates.push_back({row_gain[i], i, row_j[i]});
+            }
+            std::vector<SwapCandidate> selected = select_disjoint_swaps(candidates);
+            apply_disjoint_swaps(points, tour, selected);
+            for (const SwapCandidate& swap : selected) length -= swap.gain;
+            stats.num_swaps += selected.size();
+            improved = !selected.empty();
+        } else {
+            // Reducción determinista en orden de filas
+            double best_gain = min_improvement;
+            size_t best_i = 0, best_j = 0;
+            for (size_t i = 0; i < rows; ++i) {
+                if (row_j[i] != n && row_gain[i] > best_gain) {
+                    best_gain = row_gain[i];
                     best_i = i;
-                    best_j = j;
+                    best_j = row_j[i];
                 }
             }
+            
+            // Aplicar el mejor swap encontrado
+            if (best_gain > min_improvement) {
+                perform_2opt_swap(tour, best_i, best_j);
+                length -= best_gain;
+                stats.num_swaps++;
+                improved = true;
+            }
         }
-        
-        // Aplicar el mejor swap encontrado
-        if (best_gain > min_improvement) {
-            perform_2opt_swap(tour, best_i, best_j);
-            stats.num_swaps++;
-            improved = true;
-        }
+        stats.target_reached = options.reached(length);
         
         if (stats.iterations % 100 == 0) {
             std::cout << "\rBasic 2-Opt: Iter " << stats.iterations 
                       << ", Swaps: " << stats.num_swaps 
                       << ", Length: " << std::fixed << std::setprecision(2) 
-                      << tour_length(tour) << std::flush;
+                      << tour_length(points, tour) << std::flush;
         }
     }
     std::cout << std::endl;
     
+    for (size_t comparisons : stats.thread_comparisons) stats.total_comparisons += comparisons;
+    
     auto end_time = std::chrono::high_resolution_clock::now();
     stats.cpu_time = std::chrono::duration<double>(end_time - start_time).count();
-    stats.final_length = tour_length(tour);
+    stats.final_length = tour_length(points, tour);
     
     return stats;
 }
 
 // =============== ALGORITMO 2-OPT GEOMÉTRICO CON K-D TREE ===============
-inline OptimizationStats geometric_2opt(std::vector<Point>& tour) {
+// Los vecinos de cada ciudad salen de las listas de candidatos (K-NN del
+// K-d tree), calculadas una sola vez por instancia.
+// En modo multi-movimiento todo par mejorador de la pasada es candidato.
+inline OptimizationStats geometric_2opt(const PointSet& points, Tour& tour,
+                                        const CandidateLists& candidates,
+                                        const TwoOptOptions& options = TwoOptOptions()) {
     OptimizationStats stats;
-    stats.initial_length = tour_length(tour);
-    
-    // Construir K-d tree
-    KDTree kdtree;
-    kdtree.build(tour);
+    stats.initial_length = tour_length(points, tour);
+    stats.num_visited = candidates.nodes_visited;
     
     auto start_time = std::chrono::high_resolution_clock::now();
     bool improved = true;
     const size_t max_iterations = 1000;
     const double min_improvement = 1e-9;
+    EdgeCache cache;
+    cache.build(points, tour);
+    std::vector<SwapCandidate> swaps;
+    double length = stats.initial_length;
+    stats.target_reached = options.reached(length);
     
-    while (improved && stats.iterations < max_iterations) {
+    while (improved && stats.iterations < max_iterations && !stats.target_reached) {
         improved = false;
         stats.iterations++;
         
         double best_gain = min_improvement;
         size_t best_i = 0, best_j = 0;
-        kdtree.reset_nodes_visited();
+        size_t n = tour.size();
+        swaps.clear();
         
-        for (size_t i = 0; i < tour.size() - 2; ++i) {
-            // Radio dinámico más grande - usar promedio de distancias de aristas cercanas
-            double edge_dist = distance(tour[i], tour[(i + 1) % tour.size()]);
-            double prev_edge_dist = distance(tour[(i + tour.size() - 1) % tour.size()], tour[i]);
-            double avg_edge_dist = (edge_dist + prev_edge_dist) / 2.0;
-            
-            // Radio más generoso para encontrar más vecinos
-            double radius = std::max(avg_edge_dist * 3.0, 0.1); // Mínimo 0.1 para asegurar vecinos
-            
-            // FRNN: Fixed-Radius Near Neighbors
-            auto neighbors = kdtree.find_neighbors(tour[i], radius);
-            
-            // Si encontramos muy pocos vecinos, incrementar radio
-            if (neighbors.size() < 5) {
-                radius *= 2.0;
-                neighbors = kdtree.find_neighbors(tour[i], radius);
-            }
-            
-            for (const auto& neighbor : neighbors) {
-                // Encontrar el índice del vecino en el tour
-                auto it = std::find_if(tour.begin(), tour.end(),
-                    [&neighbor](const Point& p) { return p.id == neighbor.id; });
-                
-                if (it != tour.end()) {
-                    size_t j = it - tour.begin();
-                    if (j > i + 1 && !(j == tour.size() - 1 && i == 0)) {
-                        double gain = calculate_2opt_gain(tour, i, j);
-                        stats.total_comparisons++;
-                        
-                        if (gain > best_gain) {
-                            best_gain = gain;
-                            best_i = i;
-                            best_j = j;
-                        }
+        for (size_t i = 0; i < n; ++i) {
+            // La arista candidata (tour[i], vecino) será la nueva arista del swap
+            for (uint32_t neighbor : candidates.of(tour[i])) {
+                // Posición del vecino en el tour: O(1) con el índice inverso
+                size_t j = tour.position(neighbor);
+                size_t lo = std::min(i, j), hi = std::max(i, j);
+                if (hi > lo + 1 && !(hi == n - 1 && lo == 0)) {
+                    double gain = calculate_2opt_gain(points, tour, cache, lo, hi);
+                    stats.total_comparisons++;
+                    
+                    if (options.multi_move && gain > min_improvement) swaps.push_back({gain, lo, hi});
+                    if (gain > best_gain) {
+                        best_gain = gain;
+                        best_i = lo;
+                        best_j = hi;
                     }
                 }
             }
         }
         
-        stats.num_visited += kdtree.get_nodes_visited();
-        
-        // Aplicar el mejor swap encontrado
-        if (best_gain > min_improvement) {
-            perform_2opt_swap(tour, best_i, best_j);
+        if (options.multi_move) {
+            // Aplicar todos los swaps independientes (los pares repetidos se descartan por solape)
+            std::vector<SwapCandidate> selected = select_disjoint_swaps(swaps);
+            apply_disjoint_swaps(points, tour, selected, &cache);
+            for (const SwapCandidate& swap : selected) length -= swap.gain;
+            stats.num_swaps += selected.size();
+            improved = !selected.empty();
+        } else if (best_gain > min_improvement) {
+            // Aplicar el mejor swap encontrado
+            perform_2opt_swap(points, tour, cache, best_i, best_j);
+            length -= best_gain;
             stats.num_swaps++;
             improved = true;
-            
-            // Reconstruir K-d tree después de cambios significativos
-            if (stats.num_swaps % 25 == 0) {  // Más frecuente
-                kdtree.build(tour);
-            }
         }
+        stats.target_reached = options.reached(length);
         
         if (stats.iterations % 100 == 0) {
             std::cout << "\rGeometric 2-Opt: Iter " << stats.iterations 
                       << ", Swaps: " << stats.num_swaps 
                       << ", Length: " << std::fixed << std::setprecision(2) 
-                      << tour_length(tour) << std::flush;
+                      << tour_length(points, tour) << std::flush;
+        }
+    }
+    std::cout << std::endl;
+    
+    auto end_time = std::chrono::high_resolution_clock::now();
+    stats.cpu_time = std::chrono::duration<double>(end_time - start_time).count();
+    stats.final_length = tour_length(points, tour);
+    
+    return stats;
+}
+
+// =============== ALGORITMO 2-OPT CON DON'T-LOOK BITS (PRIMERA MEJORA) ===============
+// Cola FIFO de ciudades activas: para cada ciudad se recorre su lista de
+// candidatos en ambos sentidos del tour y se aplica la primera mejora encontrada.
+// Solo los cuatro extremos del movimiento aplicado vuelven a la cola, por lo que
+// el trabajo total es casi lineal en n.
+// Plantilla sobre la representación del tour (Tour o TwoLevelTour).
+template <class TourT>
+inline OptimizationStats dlb_2opt(const PointSet& points, TourT& tour,
+                                  const CandidateLists& candidates,
+                                  const TwoOptOptions& options = TwoOptOptions()) {
+    OptimizationStats stats;
+    stats.initial_length = tour_length(points, tour);
+    stats.num_visited = candidates.nodes_visited;
+    
+    auto start_time = std::chrono::high_resolution_clock::now();
+    const double min_improvement = 1e-9;
+    size_t n = tour.size();
+    
+    // in_queue[c] == true equivale a tener el don't-look bit de c apagado
+    std::vector<bool> in_queue(n, true);
+    auto sequence = tour_sequence(tour);
+    std::deque<uint32_t> queue(sequence.begin(), sequence.end());
+    stats.active_nodes = queue.size();
+    
+    auto activate = [&](uint32_t city) {
+        if (!in_queue[city]) {
+            in_queue[city] = true;
+            queue.push_back(city);
+        }
+    };
+    
+    EdgeCache cache;
+    cache.build(points, tour);
+    double length = stats.initial_length;
+    stats.target_reached = options.reached(length);
+    
+    while (n >= 5 && !queue.empty() && !stats.target_reached) {
+        uint32_t a = queue.front();
+        queue.pop_front();
+        in_queue[a] = false;
+        stats.iterations++;
+        
+        bool improved = false;
+        for (int dir = 0; dir < 2 && !improved; ++dir) {
+            // dir == 0: aristas (a, sucesor); dir == 1: aristas (predecesor, a)
+            uint32_t b = dir == 0 ? tour.next(a) : tour.prev(a);
+            double d_ab = cache.length(a, b);
+            
+            for (uint32_t c : candidates.of(a)) {
+                double d_ac = distance(points, a, c);
+                double g1 = d_ab - d_ac;
+                // Candidatos ordenados por distancia: ninguno posterior mejora
+                if (g1 <= min_improvement) break;
+                
+                uint32_t d = dir == 0 ? tour.next(c) : tour.prev(c);
+                if (c == b || d == a) continue;
+                
+                double d_bd = distance(points, b, d);
+                double gain = g1 + cache.length(c, d) - d_bd;
+                stats.total_comparisons++;
+                
+                if (gain > min_improvement) {
+                    make_2opt_move(tour, a, b, c, d);
+                    cache.apply_2opt(a, b, c, d, d_ac, d_bd);
+                    length -= gain;
+                    stats.target_reached = options.reached(length);
+                    stats.num_swaps++;
+                    improved = true;
+                    
+                    activate(a);
+                    activate(b);
+                    activate(c);
+                    activate(d);
+                    break;
+                }
+            }
+        }
+        
+        stats.active_nodes = std::max(stats.active_nodes, queue.size());
+        
+        if (stats.iterations % (100 * n) == 0) {
+            std::cout << "\rDLB 2-Opt: Iter " << stats.iterations 
+                      << ", Swaps: " << stats.num_swaps 
+                      << ", Queue: " << queue.size()
+                      << ", Length: " << std::fixed << std::setprecision(2) 
+                      << tour_length(points, tour) << std::flush;
         }
     }
     std::cout << std::endl;
     
     auto end_time = std::chrono::high_resolution_clock::now();
     stats.cpu_time = std::chrono::duration<double>(end_time - start_time).count();
-    stats.final_length = tour_length(tour);
+    stats.final_length = tour_length(points, tour);
     
     return stats;
 }
 
 // =============== ALGORITMO 2-OPT APROXIMADO CON BITS DE ACTIVACIÓN ===============
-inline OptimizationStats approximate_2opt(std::vector<Point>& tour) {
+// Los bits de activación son los don't-look bits del driver DLB: en lugar de
+// reescanear todos los pares activos en cada iteración, se procesa la cola de
+// ciudades activas con primera mejora.
+inline OptimizationStats approximate_2opt(const PointSet& points, Tour& tour,
+                                          const CandidateLists& candidates,
+                                          const TwoOptOptions& options = TwoOptOptions()) {
+    return dlb_2opt(points, tour, candidates, options);
+}
+
+// =============== ALGORITMO 2-OPT HÍBRIDO (COMBINACIÓN DE TÉCNICAS) ===============
+// En modo multi-movimiento se aplican todos los swaps independientes y se
+// activa el vecindario de cada uno.
+inline OptimizationStats hybrid_2opt(const PointSet& points, Tour& tour,
+                                     const CandidateLists& candidates,
+                                     const TwoOptOptions& options = TwoOptOptions()) {
     OptimizationStats stats;
-    stats.initial_length = tour_length(tour);
+    stats.initial_length = tour_length(points, tour);
+    stats.num_visited = candidates.nodes_visited;
     
-    // Inicializar todos los puntos como activos
-    for (auto& p : tour) p.active = true;
+    // Inicializar bits de activación (indexados por ciudad)
+    std::vector<bool> active(tour.size(), true);
+    EdgeCache cache;
+    cache.build(points, tour);
+    std::vector<SwapCandidate> swaps;
+    double length = stats.initial_length;
+    stats.target_reached = options.reached(length);
     
     auto start_time = std::chrono::high_resolution_clock::now();
     bool improved = true;
     const size_t max_iterations = 1000;
     const double min_improvement = 1e-9;
     
-    while (improved && stats.iterations < max_iterations) {
+    while (improved && stats.iterations < max_iterations && !stats.target_reached) {
         improved = false;
         stats.iterations++;
         
         double best_gain = min_improvement;
         size_t best_i = 0, best_j = 0;
+        size_t n = tour.size();
+        swaps.clear();
         
-        // Recopilar índices de puntos activos
+        // Obtener puntos activos
         std::vector<size_t> active_indices;
         for (size_t i = 0; i < tour.size(); ++i) {
-            if (tour[i].active) {
+            if (active[tour[i]]) {
                 active_indices.push_back(i);
             }
         }
         stats.active_nodes = active_indices.size();
         
-        // Solo evaluar swaps entre puntos activos
-        for (size_t idx_i = 0; idx_i < active_indices.size(); ++idx_i) {
-            size_t i = active_indices[idx_i];
-            for (size_t idx_j = idx_i + 1; idx_j < active_indices.size(); ++idx_j) {
-                size_t j = active_indices[idx_j];
-                if (j > i + 1 && !(j == tour.size() - 1 && i == 0)) {
-                    double gain = calculate_2opt_gain(tour, i, j);
+        // Usar las listas de candidatos solo en puntos activos
+        for (size_t i : active_indices) {
+            for (uint32_t neighbor : candidates.of(tour[i])) {
+                size_t j = tour.position(neighbor);
+                size_t lo = std::min(i, j), hi = std::max(i, j);
+                if (hi > lo + 1 && !(hi == n - 1 && lo == 0) && active[neighbor]) {
+                    double gain = calculate_2opt_gain(points, tour, cache, lo, hi);
                     stats.total_comparisons++;
                     
+                    if (options.multi_move && gain > min_improvement) swaps.push_back({gain, lo, hi});
                     if (gain > best_gain) {
                         best_gain = gain;
-                        best_i = i;
-                        best_j = j;
+                        best_i = lo;
+                        best_j = hi;
                     }
                 }
             }
         }
         
-        // Aplicar el mejor swap y actualizar bits de activación
-        if (best_gain > min_improvement) {
-            perform_2opt_swap(tour, best_i, best_j);
-            stats.num_swaps++;
+        if (options.multi_move && !swaps.empty()) {
+            std::vector<SwapCandidate> selected = select_disjoint_swaps(swaps);
+            std::vector<uint32_t> endpoints;
+            for (const SwapCandidate& swap : selected) {
+                endpoints.push_back(tour[swap.i]);
+                endpoints.push_back(tour[swap.j]);
+            }
+            apply_disjoint_swaps(points, tour, selected, &cache);
+            for (const SwapCandidate& swap : selected) length -= swap.gain;
+            stats.num_swaps += selected.size();
             improved = true;
             
-            // Desactivar todos los puntos
-            for (auto& p : tour) p.active = false;
-            
-            // Activar nodos "prometedores": vecinos de los puntos swapeados
-            size_t n = tour.size();
-            std::unordered_set<size_t> to_activate;
-            
-            // Activar vecinos de los puntos involucrados en el swap
-            for (int offset = -2; offset <= 2; ++offset) {
-                to_activate.insert((best_i + n + offset) % n);
-                to_activate.insert((best_j + n + offset) % n);
+            std::fill(active.begin(), active.end(), false);
+            for (uint32_t city : endpoints) {
+                size_t pos = tour.position(city);
+                for (int offset = -4; offset <= 4; ++offset) {
+                    active[tour[(pos + n + offset) % n]] = true;
+                }
             }
+        } else if (best_gain > min_improvement) {
+            uint32_t city_i = tour[best_i], city_j = tour[best_j];
+            perform_2opt_swap(points, tour, cache, best_i, best_j);
+            length -= best_gain;
+            stats.num_swaps++;
+            improved = true;
+            best_i = tour.position(city_i);
+            best_j = tour.position(city_j);
+            
+            // Actualizar activación de manera inteligente
+            std::fill(active.begin(), active.end(), false);
             
-            // Aplicar activación
-            for (size_t idx : to_activate) {
-                tour[idx].active = true;
+            for (int offset = -4; offset <= 4; ++offset) { // Vecindario más grande
+                active[tour[(best_i + n + offset) % n]] = true;
+                active[tour[(best_j + n + offset) % n]] = true;
             }
         } else {
-            // Si no hay mejoras, activar más nodos gradualmente
-            size_t to_activate_count = std::min(tour.size(), active_indices.size() + 10);
-            
-            // Activar nodos aleatorios adicionales
-            std::random_device rd;
-            std::mt19937 gen(rd());
-            std::uniform_int_distribution<size_t> dist(0, tour.size() - 1);
+            // Reactivar más nodos si no hay mejoras - estrategia más agresiva
+            size_t nodes_to_activate = std::min(tour.size(), std::max(active_indices.size() + 15, tour.size() / 4));
             
-            for (size_t i = active_indices.size(); i < to_activate_count; ++i) {
-                tour[dist(gen)].active = true;
+            std::fill(active.begin(), active.end(), false);
+            for (size_t i = 0; i < nodes_to_activate; i += 2) {
+                if (i < tour.size()) active[tour[i]] = true;
             }
         }
+        stats.target_reached = options.reached(length);
         
         if (stats.iterations % 100 == 0) {
-            std::cout << "\rApproximate 2-Opt: Iter " << stats.iterations 
+            std::cout << "\rHybrid 2-Opt: Iter " << stats.iterations 
                       << ", Swaps: " << stats.num_swaps 
                       << ", Active: " << stats.active_nodes
                       << ", Length: " << std::fixed << std::setprecision(2) 
-                      << tour_length(tour) << std::flush;
+                      << tour_length(points, tour) << std::flush;
         }
     }
     std::cout << std::endl;
     
     auto end_time = std::chrono::high_resolution_clock::now();
     stats.cpu_time = std::chrono::duration<double>(end_time - start_time).count();
-    stats.final_length = tour_length(tour);
+    stats.final_length = tour_length(points, tour);
     
     return stats;
-}
+} 
 
-// =============== ALGORITMO 2-OPT HÍBRIDO (COMBINACIÓN DE TÉCNICAS) ===============
-inline OptimizationStats hybrid_2opt(std::vector<Point>& tour) {
+// =============== BÚSQUEDA LOCAL OR-OPT ===============
+// Reubica segmentos de 1 a 3 ciudades (invertidos o no) junto a un vecino
+// geométrico de uno de sus extremos, usando las listas de candidatos del K-d tree.
+// Mismo esquema de cola + don't-look bits que dlb_2opt, con primera mejora.
+template <class TourT>
+inline OptimizationStats or_opt(const PointSet& points, TourT& tour,
+                                const CandidateLists& candidates,
+                                const TwoOptOptions& options = TwoOptOptions()) {
     OptimizationStats stats;
-    stats.initial_length = tour_length(tour);
-    
-    KDTree kdtree;
-    kdtree.build(tour);
-    
-    // Inicializar bits de activación
-    for (auto& p : tour) p.active = true;
+    stats.initial_length = tour_length(points, tour);
+    stats.num_visited = candidates.nodes_visited;
     
     auto start_time = std::chrono::high_resolution_clock::now();
-    bool improved = true;
-    const size_t max_iterations = 1000;
     const double min_improvement = 1e-9;
+    const size_t max_segment = 3;
+    size_t n = tour.size();
     
-    while (improved && stats.iterations < max_iterations) {
-        improved = false;
-        stats.iterations++;
+    std::vector<bool> in_queue(n, true);
+    auto sequence = tour_sequence(tour);
+    std::deque<uint32_t> queue(sequence.begin(), sequence.end());
+    stats.active_nodes = queue.size();
+    
+    auto activate = [&](uint32_t city) {
+        if (!in_queue[city]) {
+            in_queue[city] = true;
+            queue.push_back(city);
+        }
+    };
+    
+    EdgeCache cache;
+    cache.build(points, tour);
+    double current_length = stats.initial_length;
+    stats.target_reached = options.reached(current_length);
+    
+    // Intenta reubicar el segmento que empieza en s1 y avanza en el sentido dir
+    auto try_segment = [&](uint32_t s1, size_t length, int dir) -> bool {
+        auto fwd = [&](uint32_t c) { return dir == 0 ? tour.next(c) : tour.prev(c); };
+        auto back = [&](uint32_t c) { return dir == 0 ? tour.prev(c) : tour.next(c); };
         
-        double best_gain = min_improvement;
-        size_t best_i = 0, best_j = 0;
-        kdtree.reset_nodes_visited();
+        uint32_t s2 = s1;
+        for (size_t k = 1; k < length; ++k) s2 = fwd(s2);
+        uint32_t p = back(s1);
+        uint32_t nx = fwd(s2);
         
-        // Obtener puntos activos
-        std::vector<size_t> active_indices;
-        for (size_t i = 0; i < tour.size(); ++i) {
-            if (tour[i].active) {
-                active_indices.push_back(i);
+        // Ganancia de sacar el segmento y cerrar p -> nx
+        double removal_gain = cache.length(p, s1) + cache.length(s2, nx) - distance(points, p, nx);
+        if (removal_gain <= min_improvement) return false;
+        
+        auto in_segment = [&](uint32_t c) {
+            uint32_t x = s1;
+            for (size_t k = 0; k < length; ++k, x = fwd(x)) {
+                if (x == c) return true;
             }
-        }
-        stats.active_nodes = active_indices.size();
+            return false;
+        };
         
-        // Usar K-d tree solo en puntos activos
-        for (size_t i : active_indices) {
-            if (i >= tour.size() - 2) continue;
-            
-            // Radio dinámico adaptativo más generoso
-            double edge_dist = distance(tour[i], tour[(i + 1) % tour.size()]);
-            double radius = std::max(edge_dist * 4.0, 0.15); // Factor más grande y mínimo mayor
-            
-            auto neighbors = kdtree.find_neighbors_adaptive(tour[i], radius, 8); // Más vecinos mínimos
+        for (int end = 0; end < 2; ++end) {
+            // El extremo `attach` queda junto al candidato c; `other` junto a e
+            uint32_t attach = end == 0 ? s1 : s2;
+            uint32_t other = end == 0 ? s2 : s1;
+            if (end == 1 && s1 == s2) break;
             
-            for (const auto& neighbor : neighbors) {
-                auto it = std::find_if(tour.begin(), tour.end(),
-                    [&neighbor](const Point& p) { return p.id == neighbor.id; });
+            for (uint32_t c : candidates.of(attach)) {
+                double d_attach = distance(points, c, attach);
+                // Criterio de ganancia parcial positiva
+                if (removal_gain - d_attach <= min_improvement) break;
+                if (in_segment(c)) continue;
                 
-                if (it != tour.end()) {
-                    size_t j = it - tour.begin();
-                    if (j > i + 1 && !(j == tour.size() - 1 && i == 0) && tour[j].active) {
-                        double gain = calculate_2opt_gain_fast(tour, i, j);
-                        stats.total_comparisons++;
-                        
-                        if (gain > best_gain) {
-                            best_gain = gain;
-                            best_i = i;
-                            best_j = j;
-                        }
+                for (int side = 0; side < 2; ++side) {
+                    uint32_t e = side == 0 ? fwd(c) : back(c);
+                    if (in_segment(e)) continue;
+                    
+                    double gain = removal_gain + cache.length(c, e) - d_attach - distance(points, e, other);
+                    stats.total_comparisons++;
+                    if (gain <= min_improvement) continue;
+                    
+                    // Destino (tc -> td) en el sentido de p -> s1
+                    uint32_t tc = side == 0 ? c : e;
+                    uint32_t td = side == 0 ? e : c;
+                    bool reversed = (attach == s1) != (c == tc);
+                    
+                    make_or_opt_move(tour, s1, s2, p, nx, tc, td, reversed);
+                    current_length -= gain;
+                    stats.target_reached = options.reached(current_length);
+                    stats.num_swaps++;
+                    
+                    // Todas las aristas nuevas y eliminadas tienen sus extremos entre estas ciudades
+                    for (uint32_t city : {p, nx, s1, s2, c, e}) {
+                        cache.refresh(points, tour, city);
+                        activate(city);
                     }
+                    return true;
                 }
             }
         }
+        return false;
+    };
+    
+    while (n >= 8 && !queue.empty() && !stats.target_reached) {
+        uint32_t a = queue.front();
+        queue.pop_front();
+        in_queue[a] = false;
+        stats.iterations++;
         
-        stats.num_visited += kdtree.get_nodes_visited();
-        
-        if (best_gain > min_improvement) {
-            perform_2opt_swap(tour, best_i, best_j);
-            stats.num_swaps++;
-            improved = true;
-            
-            // Actualizar activación de manera inteligente
-            for (auto& p : tour) p.active = false;
-            
-            size_t n = tour.size();
-            for (int offset = -4; offset <= 4; ++offset) { // Vecindario más grande
-                tour[(best_i + n + offset) % n].active = true;
-                tour[(best_j + n + offset) % n].active = true;
+        bool improved = false;
+        for (size_t length = 1; length <= max_segment && !improved; ++length) {
+            for (int dir = 0; dir < 2 && !improved; ++dir) {
+                improved = try_segment(a, length, dir);
             }
-            
-            // Reconstruir árbol periódicamente
-            if (stats.num_swaps % 30 == 0) {
-                kdtree.build(tour);
+        }
+        
+        stats.active_nodes = std::max(stats.active_nodes, queue.size());
+        
+        if (stats.iterations % (100 * n) == 0) {
+            std::cout << "\rOr-Opt: Iter " << stats.iterations 
+                      << ", Moves: " << stats.num_swaps 
+                      << ", Queue: " << queue.size()
+                      << ", Length: " << std::fixed << std::setprecision(2) 
+                      << tour_length(points, tour) << std::flush;
+        }
+    }
+    std::cout << std::endl;
+    
+    auto end_time = std::chrono::high_resolution_clock::now();
+    stats.cpu_time = std::chrono::duration<double>(end_time - start_time).count();
+    stats.final_length = tour_length(points, tour);
+    
+    return stats;
+}
+
+// =============== 2-OPT PLANIFICADO POR SEGMENTOS ===============
+// El tour se divide en ventanas de segment_size posiciones puntuadas por su
+// longitud media de arista. El heap arranca con el ranking completo de
+// score_promising_segments (la base de find_promising_segments) y se repuntúa
+// con el mismo segment_average_edge. Las ciudades llevan
+// don't-look bits como en dlb_2opt, y un heap de máximos entrega siempre la
+// peor ventana con ciudades activas. Sobre ella corre un 2-opt DLB cuya cola
+// admite solo sus ciudades y los candidatos de éstas; las ciudades activadas
+// fuera de esa región esperan a su propia ventana. Solo se vuelven a puntuar
+// las ventanas cuyas aristas movió un movimiento, y las entradas viejas del
+// heap se descartan por versión.
+// Con score_ratio > 0 el planificador termina cuando la peor ventana activa ya
+// no supera score_ratio veces la arista media actual del tour: en tours casi
+// buenos el trabajo se concentra en las zonas malas.
+struct SegmentScheduleOptions {
+    size_t segment_size;   // Posiciones por ventana
+    double score_ratio;    // Umbral relativo a la arista media (0 = hasta vaciar el heap)
+    
+    SegmentScheduleOptions() : segment_size(32), score_ratio(0) {}
+};
+
+inline OptimizationStats segment_2opt(const PointSet& points, Tour& tour,
+                                      const CandidateLists& candidates,
+                                      const SegmentScheduleOptions& schedule = SegmentScheduleOptions(),
+                                      const TwoOptOptions& options = TwoOptOptions()) {
+    OptimizationStats stats;
+    stats.initial_length = tour_length(points, tour);
+    stats.num_visited = candidates.nodes_visited;
+    
+    auto start_time = std::chrono::high_resolution_clock::now();
+    const double min_improvement = 1e-9;
+    size_t n = tour.size();
+    size_t window = std::max<size_t>(schedule.segment_size, 2);
+    size_t num_windows = n > 0 ? (n + window - 1) / window : 0;
+    double length = stats.initial_length;
+    stats.target_reached = options.reached(length);
+    
+    EdgeCache cache;
+    cache.build(points, tour);
+    
+    // active[c] == true equivale a tener el don't-look bit de c apagado
+    std::vector<bool> active(n, true);
+    
+    // Heap (puntaje, ventana, versión): solo vale la entrada con la versión
+    // actual, y solo entran ventanas con alguna ciudad activa
+    std::vector<uint32_t> version(num_windows, 0);
+    std::priority_queue<std::tuple<double, size_t, uint32_t>> heap;
+    auto rescore = [&](size_t w) {
+        size_t begin = w * window, end = std::min(begin + window, n);
+        version[w]++;
+        bool any_active = false;
+        for (size_t i = begin; i < end && !any_active; ++i) any_active = active[tour[i]];
+        if (any_active) heap.push({segment_average_edge(points, tour, begin, end), w, version[w]});
+    };
+    for (const SegmentScore& segment : score_promising_segments(points, tour, window, num_windows)) {
+        heap.push({segment.score, segment.start / window, version[segment.start / window]});
+    }
+    
+    // Ventanas a repuntuar: las de las aristas que cambian al reversar un
+    // bloque (posiciones start - 1 .. start + length - 1, circular) y las de
+    // las ciudades activadas
+    std::vector<bool> dirty(num_windows, false);
+    std::vector<size_t> dirty_list;
+    auto mark = [&](size_t w) {
+        if (!dirty[w]) {
+            dirty[w] = true;
+            dirty_list.push_back(w);
+        }
+    };
+    auto touch = [&](std::pair<size_t, size_t> block) {
+        size_t pos = (block.first + n - 1) % n;
+        size_t count = block.second + 1;
+        while (count > 0) {
+            mark(pos / window);
+            size_t advance = std::min({count, window - pos % window, n - pos});
+            pos = (pos + advance) % n;
+            count -= advance;
+        }
+    };
+    
+    // Región de la ventana actual (ciudades y sus candidatos) y cola DLB local
+    std::vector<uint32_t> region(n, 0);
+    std::vector<bool> in_queue(n, false);
+    uint32_t round = 0;
+    std::deque<uint32_t> queue;
+    auto activate = [&](uint32_t city) {
+        active[city] = true;
+        if (region[city] == round) {
+            if (!in_queue[city]) {
+                in_queue[city] = true;
+                queue.push_back(city);
             }
         } else {
-            // Reactivar más nodos si no hay mejoras - estrategia más agresiva
-            size_t nodes_to_activate = std::min(tour.size(), std::max(active_indices.size() + 15, tour.size() / 4));
+            mark(tour.position(city) / window);
+        }
+    };
+    
+    while (n >= 5 && !heap.empty() && !stats.target_reached) {
+        auto [score, w, stamp] = heap.top();
+        heap.pop();
+        if (stamp != version[w]) continue;   // Puntaje viejo
+        if (score <= schedule.score_ratio * length / n) break;   // El resto del tour ya es bueno
+        stats.iterations++;
+        round++;
+        version[w]++;   // Sale del heap hasta que vuelva a tener ciudades activas
+        
+        size_t begin = w * window, end = std::min(begin + window, n);
+        size_t region_size = 0;
+        for (size_t i = begin; i < end; ++i) {
+            for (uint32_t city : candidates.of(tour[i])) {
+                if (region[city] != round) region_size++;
+                region[city] = round;
+            }
+        }
+        for (size_t i = begin; i < end; ++i) {
+            uint32_t city = tour[i];
+            if (region[city] != round) region_size++;
+            region[city] = round;
+            if (active[city]) {
+                in_queue[city] = true;
+                queue.push_back(city);
+            }
+        }
+        stats.active_nodes = std::max(stats.active_nodes, region_size);
+        
+        while (!queue.empty() && !stats.target_reached) {
+            uint32_t a = queue.front();
+            queue.pop_front();
+            in_queue[a] = false;
+            active[a] = false;
             
-            for (auto& p : tour) p.active = false;
-            for (size_t i = 0; i < nodes_to_activate; i += 2) {
-                if (i < tour.size()) tour[i].active = true;
+            bool improved = false;
+            for (int dir = 0; dir < 2 && !improved; ++dir) {
+                uint32_t b = dir == 0 ? tour.next(a) : tour.prev(a);
+                double d_ab = cache.length(a, b);
+                
+                for (uint32_t c : candidates.of(a)) {
+                    double d_ac = distance(points, a, c);
+                    double g1 = d_ab - d_ac;
+                    if (g1 <= min_improvement) break;
+                    
+                    uint32_t d = dir == 0 ? tour.next(c) : tour.prev(c);
+                    if (c == b || d == a) continue;
+                    
+                    double d_bd = distance(points, b, d);
+                    double gain = g1 + cache.length(c, d) - d_bd;
+                    stats.total_comparisons++;
+                    
+                    if (gain > min_improvement) {
+                        touch(reversed_block(tour, a, b, c));
+                        make_2opt_move(tour, a, b, c, d);
+                        cache.apply_2opt(a, b, c, d, d_ac, d_bd);
+                        length -= gain;
+                        stats.target_reached = options.reached(length);
+                        stats.num_swaps++;
+                        improved = true;
+                        
+                        activate(a);
+                        activate(b);
+                        activate(c);
+                        activate(d);
+                        break;
+                    }
+                }
             }
         }
         
-        if (stats.iterations % 100 == 0) {
-            std::cout << "\rHybrid 2-Opt: Iter " << stats.iterations 
-                      << ", Swaps: " << stats.num_swaps 
-                      << ", Active: " << stats.active_nodes
-                      << ", Length: " << std::fixed << std::setprecision(2) 
-                      << tour_length(tour) << std::flush;
+        // Repuntuar solo las ventanas tocadas
+        for (size_t touched : dirty_list) {
+            dirty[touched] = false;
+            rescore(touched);
+        }
+        dirty_list.clear();
+        
+        if (stats.iterations % 1000 == 0) {
+            std::cout << "\rSegment 2-Opt: Windows " << stats.iterations
+                      << ", Swaps: " << stats.num_swaps
+                      << ", Heap: " << heap.size()
+                      << ", Length: " << std::fixed << std::setprecision(2)
+                      << length << std::flush;
         }
     }
     std::cout << std::endl;
     
     auto end_time = std::chrono::high_resolution_clock::now();
     stats.cpu_time = std::chrono::duration<double>(end_time - start_time).count();
-    stats.final_length = tour_length(tour);
+    stats.final_length = tour_length(points, tour);
     
     return stats;
-} 
\ No newline at end of file
+}